@@ -418,7 +418,7 @@ void MainWindow::NextFrame(bool forward, bool set_prop)
 				//m_capture.set(cv::CAP_PROP_POS_FRAMES, slider);
 			}
             m_timeLineSlider->setSliderPosition(slider);
-            m_capture >> m_currentFrame;
+            ReadFrame(m_capture, m_mainProc.GetFramePool(), m_currentFrame);
 		}
         else if (m_directionForward)
 		{
@@ -436,7 +436,7 @@ void MainWindow::NextFrame(bool forward, bool set_prop)
 				m_capture.set(cv::CAP_PROP_POS_FRAMES, slider);
 			}
             m_timeLineSlider->setSliderPosition(slider);
-            m_capture >> m_currentFrame;
+            ReadFrame(m_capture, m_mainProc.GetFramePool(), m_currentFrame);
 		}
         else if (!m_directionForward)
 		{
@@ -458,8 +458,10 @@ void MainWindow::NextFrame(bool forward, bool set_prop)
 		//int64 t2 = cv::getTickCount();
 		if (res)
 		{
-			cv::Mat freqPlot(m_currentFrame.rows / 8, m_currentFrame.cols / 2, CV_8UC3, cv::Scalar::all(0));
-			cv::Mat signalPlot(freqPlot.rows, freqPlot.cols, freqPlot.type());
+			// Plots are cleared by DrawSignal and DrawFrequency, the buffers return to the pool on the next frames
+			FramePool& framePool = m_mainProc.GetFramePool();
+			cv::Mat freqPlot = framePool.Get(cv::Size(m_currentFrame.cols / 2, m_currentFrame.rows / 8), CV_8UC3);
+			cv::Mat signalPlot = framePool.Get(freqPlot.size(), freqPlot.type());
 			if (!m_mainProc.DrawSignal(signalPlot, false, false))
 			{
 				signalPlot = cv::Mat();
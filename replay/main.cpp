@@ -0,0 +1,283 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+#include "beat_calc/SignalPlugin.h"
+#include "beat_calc/FaceSubject.h"
+#include "common/common.h"
+#include "common/ColorTrace.h"
+#include "common/ThreadPool.h"
+
+std::mutex OutputMutex;
+std::atomic<size_t> FailedTraces(0);
+
+///
+/// \brief WriteResult
+/// The same row as HeartRateServer writes in the batch mode, remaining = -1 on the frames without face
+///
+void WriteResult(std::ofstream& resultsFile, int frameInd, int64 captureTime, int remaining, const FrequencyResults& freqResults)
+{
+	resultsFile << frameInd << ";" << captureTime << ";" << remaining << ";"
+				<< freqResults.smootFreq << ";" << freqResults.freq << ";" << freqResults.minFreq << ";" << freqResults.maxFreq << ";"
+				<< freqResults.snr << ";" << freqResults.averageCardiointerval << ";" << freqResults.currentCardiointerval << "\n";
+}
+
+///
+/// \brief The ReplayBlock class
+/// A run of records with face is sent to the plugin by AddMeasures up to the next hop boundary:
+/// up to the filled window while the plugin is collecting the signal, then by measure_hop samples.
+/// The frequency is measured once per block, the rows are written for every record of the block
+///
+class ReplayBlock
+{
+public:
+	ReplayBlock(SignalPlugin& plugin, const MeasureSettings& settings, std::ofstream& resultsFile)
+		: m_plugin(plugin), m_settings(settings), m_resultsFile(resultsFile)
+	{
+		m_times.reserve(m_settings.m_sampleSize);
+		m_rgb.reserve(3 * m_settings.m_sampleSize);
+		m_frames.reserve(m_settings.m_sampleSize);
+	}
+
+	///
+	void Add(const ColorTraceRecord& record, int frameInd)
+	{
+		if (m_times.empty())
+		{
+			int remaining = m_plugin.RemainingMeasurements();
+			m_blockSize = (remaining > 0) ? remaining : std::max(1, m_settings.m_measureHop);
+		}
+		m_times.push_back(record.m_captureTime);
+		m_rgb.insert(m_rgb.end(), record.m_rgb, record.m_rgb + 3);
+		m_frames.push_back(frameInd);
+		if (static_cast<int>(m_times.size()) >= m_blockSize)
+		{
+			Measure();
+		}
+	}
+
+	///
+	/// \brief Measure
+	/// Send the block to the plugin and write the rows: the plugin doesn't measure inside the block,
+	/// so the records before the last one have the previous result
+	///
+	void Measure()
+	{
+		if (m_times.empty())
+		{
+			return;
+		}
+		const int count = static_cast<int>(m_times.size());
+
+		FrequencyResults freqResults;
+		int remaining = m_plugin.RemainingMeasurements();
+		if (remaining == 0)
+		{
+			m_plugin.GetFrequency(&freqResults);
+		}
+
+		m_plugin.AddMeasures(count, m_times.data(), m_rgb.data());
+		m_plugin.MeasureFrequency(m_settings.m_freq, m_frames.back(), false);
+		m_samples += count;
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (i + 1 < count)
+			{
+				remaining = std::max(0, remaining - 1);
+			}
+			else
+			{
+				remaining = m_plugin.RemainingMeasurements();
+				if (remaining == 0)
+				{
+					m_plugin.GetFrequency(&freqResults);
+				}
+			}
+			WriteResult(m_resultsFile, m_frames[i], m_times[i], remaining, freqResults);
+		}
+		m_times.clear();
+		m_rgb.clear();
+		m_frames.clear();
+	}
+
+	///
+	/// \brief Reset
+	/// The face was lost: the same as MainProcess::SignalStage
+	///
+	void Reset()
+	{
+		Measure();
+		m_plugin.Reset();
+	}
+
+	size_t Samples() const
+	{
+		return m_samples;
+	}
+
+private:
+	SignalPlugin& m_plugin;
+	const MeasureSettings& m_settings;
+	std::ofstream& m_resultsFile;
+
+	std::vector<__int64> m_times;
+	std::vector<double> m_rgb;
+	std::vector<int> m_frames;
+	int m_blockSize = 1;
+	size_t m_samples = 0;
+};
+
+///
+/// \brief ReplayTrace
+/// Results are written to <trace file>_freq.csv: one row per trace record, the same format as HeartRateServer --batch
+/// \return false if the trace or the plugin wasn't opened
+///
+bool ReplayTrace(const std::string& traceName, MeasureSettings settings)
+{
+	ColorTraceReader reader;
+	if (!reader.Open(traceName))
+	{
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cerr << traceName << ": isn't a trace file!" << std::endl;
+		return false;
+	}
+	settings.m_freq = reader.Header().m_freq;
+	settings.m_fps = reader.Header().m_fps;
+
+	SignalPlugin plugin;
+	if (!plugin.LoadPlugin(settings.m_signalLib))
+	{
+		return false;
+	}
+	InputParams inputParams = MakeInputParams(settings);
+	if (!plugin.Init(&inputParams))
+	{
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cerr << traceName << ": plugin " << settings.m_signalLib << " wasn't created!" << std::endl;
+		return false;
+	}
+
+	std::string resultsFileName = traceName + "_freq.csv";
+	std::ofstream resultsFile(resultsFileName);
+	if (!resultsFile.is_open())
+	{
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cerr << "Can't create " << resultsFileName << std::endl;
+		return false;
+	}
+	resultsFile << "frame;capture_time;remaining;smooth_freq;freq;min_freq;max_freq;snr;average_ci;current_ci\n";
+
+	int64 t1 = cv::getTickCount();
+
+	std::vector<ColorTraceRecord> records(4096);
+	ReplayBlock block(plugin, settings, resultsFile);
+	int frameInd = 0;
+	for (size_t count = reader.Read(records.data(), records.size()); count > 0; count = reader.Read(records.data(), records.size()))
+	{
+		for (size_t i = 0; i < count; ++i, ++frameInd)
+		{
+			const ColorTraceRecord& record = records[i];
+			if (record.m_flags & ColorTraceRecord::FaceFound)
+			{
+				block.Add(record, frameInd);
+			}
+			else
+			{
+				block.Reset();
+				WriteResult(resultsFile, frameInd, record.m_captureTime, -1, FrequencyResults());
+			}
+		}
+	}
+	block.Measure();
+
+	double seconds = (cv::getTickCount() - t1) / cv::getTickFrequency();
+	std::lock_guard<std::mutex> lock(OutputMutex);
+	std::cout << traceName << ": " << frameInd << " frames, " << block.Samples() << " samples in " << seconds << " sec ("
+			  << (block.Samples() / std::max(seconds, 1e-9)) << " samples/sec)" << std::endl;
+	return true;
+}
+
+///
+/// \brief main
+/// HeartRateReplay <config file> [--threads N] <trace file> [<trace file> ...]
+/// Feeds the traces recorded with save_trace = 1 to the signal plugin from the config
+/// \param argc
+/// \param argv
+/// \return
+///
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <config file> [--threads N] <trace file> ..." << std::endl;
+		return -1;
+	}
+
+	std::string appFullPath(argv[0]);
+	std::string appDirPath = appFullPath.substr(0, appFullPath.find_last_of(PathSeparator()));
+	if (appFullPath == appDirPath)
+	{
+		appDirPath = "";
+	}
+	else
+	{
+		appDirPath += PathSeparator();
+	}
+
+	std::string confFileNameFull = appDirPath + argv[1];
+	MeasureSettings settings;
+	if (!settings.ParseOptions(confFileNameFull))
+	{
+		std::cerr << "Config file \"" << confFileNameFull << "\' is not opened!" << std::endl;
+		return -2;
+	}
+
+	size_t threadsCount = 0;
+	std::vector<std::string> traces;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			threadsCount = static_cast<size_t>(std::max(0, atoi(argv[++i])));
+		}
+		else
+		{
+			traces.push_back(arg);
+		}
+	}
+
+	cv::setNumThreads(1);
+
+	// Every trace has own plugin instance
+	ThreadPool pool(threadsCount);
+	for (const auto& trace : traces)
+	{
+		pool.Submit([trace, &settings]()
+		{
+			// An exception stops only this trace
+			try
+			{
+				ReplayTrace(trace, settings);
+			}
+			catch (const std::exception& ex)
+			{
+				++FailedTraces;
+				std::lock_guard<std::mutex> lock(OutputMutex);
+				std::cerr << trace << ": failed: " << ex.what() << std::endl;
+			}
+		});
+	}
+	pool.WaitAll();
+
+	if (FailedTraces || pool.FailedTasks())
+	{
+		std::cerr << (FailedTraces + pool.FailedTasks()) << " of " << traces.size() << " traces failed" << std::endl;
+		return -3;
+	}
+	return 0;
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+#include <opencv2/core/ocl.hpp>
+
+#include "beat_calc/MainProcess.h"
+#include "common/common.h"
+#include "common/ThreadPool.h"
+
+///
+/// \brief The Stream struct
+/// One video source with own MainProcess
+///
+struct Stream
+{
+	std::string m_source;
+	MeasureSettings m_settings;
+	cv::VideoCapture m_capture;
+	std::unique_ptr<MainProcess> m_mainProc;
+
+	cv::Mat m_frame;
+	cv::Mat m_imgProc;
+	cv::Scalar m_colorVal;
+	int m_frameInd = 0;
+
+	// Batch mode: FrequencyResults for every frame
+	std::ofstream m_resultsFile;
+};
+
+std::mutex OutputMutex;
+std::atomic<size_t> FailedStreams(0);
+
+///
+/// \brief OpenStream
+/// \return false if the source wasn't opened
+///
+bool OpenStream(Stream& stream, const std::string& source, const MeasureSettings& settings, const SharedResources& resources, const std::string& appDirPath, bool batchMode)
+{
+	stream.m_source = source;
+	stream.m_settings = settings;
+	stream.m_settings.m_useFPS = true;
+	stream.m_settings.m_fps = 25;
+	stream.m_settings.m_freq = cv::getTickFrequency();
+	if (!OpenCapture(source, stream.m_capture, stream.m_settings.m_useFPS, stream.m_settings.m_freq, stream.m_settings.m_fps, stream.m_settings.m_cameraBackend))
+	{
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cerr << source << ": file or cam not opened!" << std::endl;
+		return false;
+	}
+	if (batchMode)
+	{
+		std::string resultsFileName = source + "_freq.csv";
+		stream.m_resultsFile.open(resultsFileName);
+		if (!stream.m_resultsFile.is_open())
+		{
+			std::lock_guard<std::mutex> lock(OutputMutex);
+			std::cerr << "Can't create " << resultsFileName << std::endl;
+			return false;
+		}
+		stream.m_resultsFile << "frame;capture_time;remaining;smooth_freq;freq;min_freq;max_freq;snr;average_ci;current_ci\n";
+	}
+	stream.m_mainProc = std::make_unique<MainProcess>(appDirPath);
+	return stream.m_mainProc->Init(stream.m_settings, "", resources);
+}
+
+///
+/// \brief ProcessFrame
+/// \return false in the end of the stream
+///
+bool ProcessFrame(Stream& stream)
+{
+	stream.m_capture >> stream.m_frame;
+	if (stream.m_frame.empty())
+	{
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cout << stream.m_source << ": finished on " << stream.m_frameInd << " frame" << std::endl;
+		return false;
+	}
+
+	int64 captureTime = stream.m_settings.m_useFPS ? static_cast<int64>((stream.m_frameInd * 1000.) / stream.m_settings.m_fps) : cv::getTickCount();
+	bool faceFound = stream.m_mainProc->Process(stream.m_frame, stream.m_imgProc, captureTime, stream.m_colorVal, false, false, false, false);
+
+	if (stream.m_resultsFile.is_open())
+	{
+		FrequencyResults freqResults;
+		int remaining = faceFound ? stream.m_mainProc->RemainingMeasurements() : -1;
+		if (remaining == 0)
+		{
+			stream.m_mainProc->GetFrequency(&freqResults);
+		}
+		stream.m_resultsFile << stream.m_frameInd << ";" << captureTime << ";" << remaining << ";"
+							 << freqResults.smootFreq << ";" << freqResults.freq << ";" << freqResults.minFreq << ";" << freqResults.maxFreq << ";"
+							 << freqResults.snr << ";" << freqResults.averageCardiointerval << ";" << freqResults.currentCardiointerval << "\n";
+	}
+	// Print the result once per second
+	else if (faceFound && stream.m_frameInd % std::max(1, cvRound(stream.m_settings.m_fps)) == 0 && stream.m_mainProc->RemainingMeasurements() == 0)
+	{
+		FrequencyResults freqResults;
+		stream.m_mainProc->GetFrequency(&freqResults);
+
+		std::lock_guard<std::mutex> lock(OutputMutex);
+		std::cout << stream.m_source << ": " << stream.m_frameInd << ": freq = " << freqResults.smootFreq << ", snr = " << freqResults.snr << std::endl;
+	}
+
+	++stream.m_frameInd;
+	return true;
+}
+
+///
+/// \brief ReportFailure
+/// An exception stops only the stream that threw it
+///
+void ReportFailure(const std::string& source, int frameInd, const char* what)
+{
+	++FailedStreams;
+	std::lock_guard<std::mutex> lock(OutputMutex);
+	std::cerr << source << ": failed on " << frameInd << " frame: " << what << std::endl;
+}
+
+///
+/// \brief SafeProcessFrame
+/// \return false in the end of the stream or if the stream failed
+///
+bool SafeProcessFrame(Stream& stream)
+{
+	try
+	{
+		return ProcessFrame(stream);
+	}
+	catch (const std::exception& ex)
+	{
+		ReportFailure(stream.m_source, stream.m_frameInd, ex.what());
+	}
+	catch (...)
+	{
+		ReportFailure(stream.m_source, stream.m_frameInd, "unknown exception");
+	}
+	return false;
+}
+
+///
+/// \brief StreamStep
+/// Process one frame of the stream and submit the next step to the pool.
+/// Only one step of the stream is in the pool at any time so the frames are processed in order
+///
+void StreamStep(ThreadPool& pool, Stream& stream)
+{
+	if (SafeProcessFrame(stream))
+	{
+		pool.Submit([&pool, &stream]() { StreamStep(pool, stream); });
+	}
+}
+
+///
+/// \brief main
+/// HeartRateServer <config file> [--threads N] [--batch] <video file or camera index> [<video file or camera index> ...]
+/// --batch: the files are processed as fast as possible, results of every frame are written to <video file>_freq.csv
+/// \param argc
+/// \param argv
+/// \return
+///
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <config file> [--threads N] [--batch] <video file or camera index> ..." << std::endl;
+		return -1;
+	}
+
+	std::string appFullPath(argv[0]);
+	std::string appDirPath = appFullPath.substr(0, appFullPath.find_last_of(PathSeparator()));
+	if (appFullPath == appDirPath)
+	{
+		appDirPath = "";
+	}
+	else
+	{
+		appDirPath += PathSeparator();
+	}
+
+	std::string confFileNameFull = appDirPath + argv[1];
+	MeasureSettings settings;
+	if (!settings.ParseOptions(confFileNameFull))
+	{
+		std::cerr << "Config file \"" << confFileNameFull << "\' is not opened!" << std::endl;
+		return -2;
+	}
+
+	size_t threadsCount = 0;
+	bool batchMode = false;
+	std::vector<std::string> sources;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			threadsCount = static_cast<size_t>(std::max(0, atoi(argv[++i])));
+		}
+		else if (arg == "--batch")
+		{
+			batchMode = true;
+		}
+		else
+		{
+			sources.push_back(arg);
+		}
+	}
+
+	cv::ocl::setUseOpenCL(settings.m_useOCL);
+	// Streams are processed in parallel by the pool, the internal OpenCV threads only compete with them
+	cv::setNumThreads(1);
+
+	// Skin model is loaded once for all streams, the face detector - once for every pool worker
+	SharedResources resources;
+	if (!resources.Init(settings, appDirPath))
+	{
+		std::cerr << "Face detector wasn't created!" << std::endl;
+		return -3;
+	}
+
+	ThreadPool pool(threadsCount);
+	std::cout << sources.size() << " sources on " << pool.ThreadsCount() << " threads" << std::endl;
+
+	std::vector<std::unique_ptr<Stream>> streams;
+	if (batchMode)
+	{
+		// One task per file: only ThreadsCount() files are opened at the same time
+		for (const auto& source : sources)
+		{
+			pool.Submit([source, &settings, &resources, &appDirPath]()
+			{
+				Stream stream;
+				bool opened = false;
+				try
+				{
+					opened = OpenStream(stream, source, settings, resources, appDirPath, true);
+				}
+				catch (const std::exception& ex)
+				{
+					ReportFailure(source, 0, ex.what());
+				}
+				if (opened)
+				{
+					while (SafeProcessFrame(stream))
+					{
+					}
+				}
+			});
+		}
+	}
+	else
+	{
+		for (const auto& source : sources)
+		{
+			std::unique_ptr<Stream> stream = std::make_unique<Stream>();
+			if (OpenStream(*stream, source, settings, resources, appDirPath, false))
+			{
+				streams.push_back(std::move(stream));
+			}
+		}
+		for (auto& stream : streams)
+		{
+			Stream* streamPtr = stream.get();
+			pool.Submit([&pool, streamPtr]() { StreamStep(pool, *streamPtr); });
+		}
+	}
+	pool.WaitAll();
+
+	if (FailedStreams || pool.FailedTasks())
+	{
+		std::cerr << (FailedStreams + pool.FailedTasks()) << " of " << sources.size() << " sources failed" << std::endl;
+		return -4;
+	}
+	return 0;
+}
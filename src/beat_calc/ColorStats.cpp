@@ -0,0 +1,72 @@
+#include "ColorStats.h"
+
+///
+/// \brief CalcColorStats
+/// \param image
+/// \param mask
+/// \param stats
+///
+void CalcColorStats(cv::Mat image, cv::Mat mask, ColorStats& stats)
+{
+	CV_Assert(image.type() == CV_8UC3 && (mask.empty() || (mask.type() == CV_8UC1 && mask.size() == image.size())));
+
+	constexpr int nVals = 256;
+	unsigned int hist[3][nVals] = { { 0 } };
+	for (int y = 0; y < image.rows; ++y)
+	{
+		const uchar* imgPtr = image.ptr(y);
+		if (mask.empty())
+		{
+			for (int x = 0; x < image.cols; ++x, imgPtr += 3)
+			{
+				++hist[0][imgPtr[0]];
+				++hist[1][imgPtr[1]];
+				++hist[2][imgPtr[2]];
+			}
+		}
+		else
+		{
+			const uchar* maskPtr = mask.ptr(y);
+			for (int x = 0; x < image.cols; ++x, imgPtr += 3)
+			{
+				if (maskPtr[x])
+				{
+					++hist[0][imgPtr[0]];
+					++hist[1][imgPtr[1]];
+					++hist[2][imgPtr[2]];
+				}
+			}
+		}
+	}
+
+	stats = ColorStats();
+	for (int i = 0; i < nVals; ++i)
+	{
+		stats.m_count += hist[0][i];
+	}
+	if (!stats.m_count)
+	{
+		return;
+	}
+	for (int c = 0; c < 3; ++c)
+	{
+		uint64 sum = 0;
+		uint64 sumSqr = 0;
+		uint64 cdf = 0;
+		int median = -1;
+		for (int i = 0; i < nVals; ++i)
+		{
+			sum += static_cast<uint64>(i) * hist[c][i];
+			sumSqr += static_cast<uint64>(i * i) * hist[c][i];
+			cdf += hist[c][i];
+			if (median < 0 && 2 * cdf >= stats.m_count)
+			{
+				median = i;
+			}
+		}
+		double mean = static_cast<double>(sum) / stats.m_count;
+		stats.m_mean[c] = mean;
+		stats.m_median[c] = static_cast<double>(median) / nVals;
+		stats.m_variance[c] = std::max(0., static_cast<double>(sumSqr) / stats.m_count - mean * mean);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "opencv2/opencv.hpp"
+
+///
+/// \brief The ColorStats struct
+/// Color statistics of the pixels under the mask
+///
+struct ColorStats
+{
+	cv::Scalar m_mean;
+	cv::Scalar m_median;    // Median value divided by 256
+	cv::Scalar m_variance;
+	size_t m_count = 0;     // Number of the pixels under the mask
+};
+
+///
+/// \brief CalcColorStats
+/// One pass over the image builds the channel histograms, all statistics are calculated from them
+/// \param image - CV_8UC3
+/// \param mask - CV_8UC1 with the same size or empty for the all pixels
+///
+void CalcColorStats(cv::Mat image, cv::Mat mask, ColorStats& stats);
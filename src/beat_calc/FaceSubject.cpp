@@ -0,0 +1,224 @@
+#include "FaceSubject.h"
+
+///
+/// \brief MakeInputParams
+/// \param settings
+/// \return
+///
+InputParams MakeInputParams(const MeasureSettings& settings)
+{
+	InputParams inputParams;
+	inputParams.framesCount = settings.m_sampleSize;
+	inputParams.filterType = settings.m_filterType;
+	inputParams.signalNormalization = settings.m_signalNormalization;
+	inputParams.gauss_def_var = settings.m_gauss_def_var;
+	inputParams.gauss_min_var = settings.m_gauss_min_var;
+	inputParams.gauss_max_var = settings.m_gauss_max_var;
+	inputParams.gauss_eps = settings.m_gauss_eps;
+	inputParams.gauss_update_alpha = settings.m_gauss_update_alpha;
+	inputParams.gauss_proc_alpha = settings.m_gauss_proc_alpha;
+	inputParams.gauss_proc_weight_thresh = settings.m_gauss_proc_weight_thresh;
+	inputParams.retExpFreq = settings.m_return_exp_frequency;
+	inputParams.fps = static_cast<float>(settings.m_fps);
+	inputParams.interpolation = settings.m_interpolation;
+	inputParams.bandSpectrum = settings.m_bandSpectrum;
+	inputParams.fftSize = settings.m_fftSize;
+	inputParams.peakInterpolation = settings.m_peakInterpolation;
+	inputParams.measureHop = settings.m_measureHop;
+	return inputParams;
+}
+
+///
+/// \brief FaceSubject::FaceSubject
+/// \param id
+/// \param faceRect
+///
+FaceSubject::FaceSubject(int id, const cv::Rect& faceRect)
+{
+	m_info.m_id = id;
+	m_info.m_faceRect = faceRect;
+}
+
+///
+/// \brief FaceSubject::~FaceSubject
+///
+FaceSubject::~FaceSubject()
+{
+	if (m_tracker && !m_tracker.empty())
+	{
+		m_tracker.release();
+	}
+}
+
+///
+/// \brief FaceSubject::Init
+/// \param settings
+/// \param skinModel
+/// \return
+///
+bool FaceSubject::Init(const MeasureSettings& settings, const SkinDetector& skinModel)
+{
+	m_useSkinDetection = settings.m_useSkinDetection && m_skinDetector.InitModel(skinModel);
+	m_skinDetector.SetRefreshPeriod(settings.m_skinRefresh);
+	m_calcMean = settings.m_calcMean;
+	m_freq = settings.m_freq;
+
+	if (!m_signalProcessor.LoadPlugin(settings.m_signalLib))
+	{
+		return false;
+	}
+	InputParams inputParams = MakeInputParams(settings);
+	return m_signalProcessor.Init(&inputParams);
+}
+
+///
+/// \brief FaceSubject::GetId
+/// \return
+///
+int FaceSubject::GetId() const
+{
+	return m_info.m_id;
+}
+
+///
+/// \brief FaceSubject::GetFaceRect
+/// \return
+///
+const cv::Rect& FaceSubject::GetFaceRect() const
+{
+	return m_info.m_faceRect;
+}
+
+///
+/// \brief FaceSubject::MissedFrames
+/// \return
+///
+int FaceSubject::MissedFrames() const
+{
+	return m_missedFrames;
+}
+
+///
+/// \brief FaceSubject::Track
+/// \param rgbFrame
+/// \return
+///
+bool FaceSubject::Track(cv::Mat rgbFrame)
+{
+	m_info.m_found = false;
+
+	cv::Rect& faceRect = m_info.m_faceRect;
+	if (faceRect.empty() || !m_tracker || m_tracker.empty())
+	{
+		return false;
+	}
+
+	cv::Rect2d newRect;
+	if (!m_tracker->update(rgbFrame, newRect))
+	{
+		++m_missedFrames;
+		return false;
+	}
+	faceRect.x = static_cast<int>(newRect.x);
+	faceRect.y = static_cast<int>(newRect.y);
+	faceRect.width = static_cast<int>(newRect.width);
+	faceRect.height = static_cast<int>(newRect.height);
+	faceRect &= cv::Rect(0, 0, rgbFrame.cols - 1, rgbFrame.rows - 1);
+	m_missedFrames = 0;
+	m_info.m_found = !faceRect.empty();
+	return m_info.m_found;
+}
+
+///
+/// \brief FaceSubject::Detected
+/// \param faceRect
+/// \param rgbFrame
+///
+void FaceSubject::Detected(const cv::Rect& faceRect, cv::Mat rgbFrame)
+{
+	// TrackerKCF::init asserts on the empty box: the face outside the frame is missed
+	cv::Rect rect = faceRect & cv::Rect(0, 0, rgbFrame.cols - 1, rgbFrame.rows - 1);
+	if (rect.area() <= 0)
+	{
+		m_tracker.release();
+		m_info.m_found = false;
+		Missed();
+		return;
+	}
+
+	m_info.m_faceRect = faceRect;
+	m_info.m_found = true;
+	m_missedFrames = 0;
+	m_skinDetector.Refresh();
+
+	// Tracker is initialized on the detection frame, so the previous frame isn't kept
+	cv::TrackerKCF::Params params;
+	params.compressed_size = 1;
+	params.desc_pca = cv::TrackerKCF::CN;
+	params.desc_npca = cv::TrackerKCF::CN;
+	params.resize = true;
+	params.detect_thresh = 0.5f;
+	m_tracker = cv::TrackerKCF::create(params);
+	m_tracker->init(rgbFrame, cv::Rect2d(rect.x, rect.y, rect.width, rect.height));
+}
+
+///
+/// \brief FaceSubject::Missed
+///
+void FaceSubject::Missed()
+{
+	++m_missedFrames;
+}
+
+///
+/// \brief FaceSubject::Process
+/// \param rgbFrame
+/// \param imgProc
+/// \param captureTime
+/// \param frameInd
+///
+void FaceSubject::Process(cv::Mat rgbFrame, cv::Mat imgProc, int64 captureTime, int frameInd)
+{
+	if (!m_signalProcessor.IsLoaded())
+	{
+		return;
+	}
+	cv::Rect faceRect = m_info.m_faceRect & cv::Rect(0, 0, rgbFrame.cols - 1, rgbFrame.rows - 1);
+	if (!m_info.m_found || faceRect.area() == 0)
+	{
+		// The last known rect is kept for the matching with detections, but the face isn't there:
+		// the measurement starts again as in the single face mode
+		m_signalProcessor.Reset();
+		m_info.m_remainingMeasurements = m_signalProcessor.RemainingMeasurements();
+		return;
+	}
+
+	cv::Mat skinMask;
+	if (m_useSkinDetection)
+	{
+		skinMask = m_skinDetector.Detect(rgbFrame(faceRect), false, false, frameInd);
+	}
+
+	ColorStats stats;
+	CalcColorStats(imgProc(faceRect), skinMask, stats);
+	cv::Scalar& colorVal = m_info.m_colorVal;
+	colorVal = m_calcMean ? stats.m_mean : stats.m_median;
+
+	m_signalProcessor.AddMeasure(captureTime, colorVal.val);
+	m_signalProcessor.MeasureFrequency(m_freq, frameInd, false);
+
+	m_info.m_remainingMeasurements = m_signalProcessor.RemainingMeasurements();
+	if (m_info.m_remainingMeasurements == 0)
+	{
+		m_signalProcessor.GetFrequency(&m_info.m_freqResults);
+	}
+}
+
+///
+/// \brief FaceSubject::GetInfo
+/// \return
+///
+const SubjectInfo& FaceSubject::GetInfo() const
+{
+	return m_info;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <memory>
+
+#include "SignalPlugin.h"
+#include "ColorStats.h"
+
+#include "../detect_track/SkinDetector.h"
+#include "../common/common.h"
+
+#include <opencv2/tracking.hpp>
+
+///
+/// \brief MakeInputParams
+/// Signal processing plugin parameters from the settings
+///
+InputParams MakeInputParams(const MeasureSettings& settings);
+
+///
+/// \brief The SubjectInfo struct
+/// Measurement results of the one person in the multi-face mode
+///
+struct SubjectInfo
+{
+	int m_id = 0;                         // Track ID
+	cv::Rect m_faceRect;
+	bool m_found = false;                 // Face was tracked or detected on the current frame, otherwise m_faceRect is the last known position
+	cv::Scalar m_colorVal;
+	int m_remainingMeasurements = 0;
+	FrequencyResults m_freqResults;       // Filled when m_remainingMeasurements == 0
+};
+
+///
+/// \brief The FaceSubject class
+/// Tracker, skin detector and signal processing plugin of the one person in the frame
+///
+class FaceSubject
+{
+public:
+	FaceSubject(int id, const cv::Rect& faceRect);
+	~FaceSubject();
+
+	///
+	/// \brief Init
+	/// \param settings
+	/// \param skinModel - skin detector with already loaded model, the model is shared between subjects
+	///
+	bool Init(const MeasureSettings& settings, const SkinDetector& skinModel);
+
+	int GetId() const;
+	const cv::Rect& GetFaceRect() const;
+	///
+	/// \brief MissedFrames
+	/// Number of the frames from the last successful detection or tracking
+	///
+	int MissedFrames() const;
+
+	///
+	/// \brief Track
+	/// \param rgbFrame - current frame
+	/// \return false if the tracker lost the face
+	///
+	bool Track(cv::Mat rgbFrame);
+	///
+	/// \brief Detected
+	/// Detector found this subject on the current frame, the tracker is initialized on it
+	///
+	void Detected(const cv::Rect& faceRect, cv::Mat rgbFrame);
+	///
+	/// \brief Missed
+	/// Detector didn't find this subject on the current frame
+	///
+	void Missed();
+
+	///
+	/// \brief Process
+	/// Skin detection, color value of the face and heart rate measurement.
+	/// The signal plugin is reset if the face wasn't tracked or detected on this frame
+	/// \param rgbFrame - input frame
+	/// \param imgProc - frame after motion amplification
+	///
+	void Process(cv::Mat rgbFrame, cv::Mat imgProc, int64 captureTime, int frameInd);
+
+	const SubjectInfo& GetInfo() const;
+
+private:
+	SubjectInfo m_info;
+	int m_missedFrames = 0;
+
+	cv::Ptr<cv::Tracker> m_tracker;
+	SkinDetector m_skinDetector;
+	SignalPlugin m_signalProcessor;
+
+	bool m_useSkinDetection = false;
+	bool m_calcMean = true;
+	double m_freq = 1000;
+};
@@ -3,38 +3,31 @@
 #include "../eulerian_ma/SimpleMA.h"
 
 ///
-/// \brief MedianMat
+/// \brief CopyOutside
+/// Copy the pixels out of the rect, the rect is inside the frame
+/// \param src
+/// \param dst - the same size and type as src
+/// \param rect
 ///
-double MedianMat(cv::Mat Input, int nVals)
+static void CopyOutside(cv::Mat src, cv::Mat dst, const cv::Rect& rect)
 {
-	// COMPUTE HISTOGRAM OF SINGLE CHANNEL MATRIX
-	float range[] = { 0, static_cast<float>(nVals) };
-	const float* histRange = { range };
-	bool uniform = true;
-	bool accumulate = false;
-	cv::Mat hist;
-	calcHist(&Input, 1, 0, cv::Mat(), hist, 1, &nVals, &histRange, uniform, accumulate);
-
-	// COMPUTE CUMULATIVE DISTRIBUTION FUNCTION (CDF)
-	cv::Mat cdf;
-	hist.copyTo(cdf);
-	for (int i = 1; i <= nVals - 1; i++)
+	if (rect.y > 0)
 	{
-		cdf.at<float>(i) += cdf.at<float>(i - 1);
+		src.rowRange(0, rect.y).copyTo(dst.rowRange(0, rect.y));
 	}
-	cdf /= static_cast<float>(Input.total());
-
-	// COMPUTE MEDIAN
-	double medianVal = 0;
-	for (int i = 0; i <= nVals - 1; i++)
+	if (rect.y + rect.height < src.rows)
 	{
-		if (cdf.at<float>(i) >= 0.5)
-		{
-			medianVal = i;
-			break;
-		}
+		src.rowRange(rect.y + rect.height, src.rows).copyTo(dst.rowRange(rect.y + rect.height, src.rows));
+	}
+	cv::Range rows(rect.y, rect.y + rect.height);
+	if (rect.x > 0)
+	{
+		src(rows, cv::Range(0, rect.x)).copyTo(dst(rows, cv::Range(0, rect.x)));
+	}
+	if (rect.x + rect.width < src.cols)
+	{
+		src(rows, cv::Range(rect.x + rect.width, src.cols)).copyTo(dst(rows, cv::Range(rect.x + rect.width, src.cols)));
 	}
-	return medianVal / nVals;
 }
 
 ///
@@ -55,6 +48,9 @@ MainProcess::MainProcess(const std::string& appDirPath)
 ///
 MainProcess::~MainProcess()
 {
+	StopPipeline(false);
+	m_traceWriter.Close();
+
 #if !USE_LK_TRACKER
 	if (m_faceTracker && !m_faceTracker.empty())
 	{
@@ -68,6 +64,33 @@ MainProcess::~MainProcess()
 	}
 }
 
+///
+/// \brief SharedResources::Init
+/// \param settings
+/// \param appDirPath
+/// \return
+///
+bool SharedResources::Init(const MeasureSettings& settings, const std::string& appDirPath)
+{
+	auto factory = [settings, appDirPath]()
+	{
+		return CreateFaceDetector(settings.m_faceDetectorType, appDirPath, settings.m_useOCL);
+	};
+	std::unique_ptr<FaceDetectorBase> faceDetector(factory());
+	if (!faceDetector)
+	{
+		return false;
+	}
+	m_faceDetector = std::make_shared<PerThreadFaceDetector>(factory, std::move(faceDetector));
+
+	m_skinDetector = std::make_shared<SkinDetector>();
+	if (!SkinInit(*m_skinDetector, appDirPath + "data" + PathSeparator()))
+	{
+		m_skinDetector.reset();
+	}
+	return true;
+}
+
 ///
 /// \brief MainProcess::Init
 /// \param settings
@@ -75,42 +98,69 @@ MainProcess::~MainProcess()
 ///
 bool MainProcess::Init(const MeasureSettings& settings, const std::string& videoName)
 {
+	return Init(settings, videoName, SharedResources());
+}
+
+///
+/// \brief MainProcess::Init
+/// \param settings
+/// \param videoName
+/// \param resources - face detector and skin model shared with the other instances
+/// \return
+///
+bool MainProcess::Init(const MeasureSettings& settings, const std::string& videoName, const SharedResources& resources)
+{
+	StopPipeline(false);
+
     m_settings = settings;
 
     cv::ocl::setUseOpenCL(m_settings.m_useOCL);
     std::cout << (cv::ocl::useOpenCL() ? "OpenCL is enabled" : "OpenCL not used") << std::endl;
 
-	m_faceDetector = std::unique_ptr<FaceDetectorBase>(CreateFaceDetector(m_settings.m_faceDetectorType, m_appDirPath, m_settings.m_useOCL));
+	// Async detector works with the previous face detector
+	m_asyncDetector.reset();
+	if (resources.m_faceDetector)
+	{
+		m_faceDetector = resources.m_faceDetector;
+	}
+	else
+	{
+		m_faceDetector = std::shared_ptr<FaceDetectorBase>(CreateFaceDetector(m_settings.m_faceDetectorType, m_appDirPath, m_settings.m_useOCL));
+	}
+	m_detectScheduler.Init(m_settings.m_detectPeriodMin, m_settings.m_detectPeriodMax);
+	m_trackHistory.clear();
+	if (m_settings.m_asyncDetection && !m_settings.m_multiFace && m_faceDetector)
+	{
+		m_asyncDetector = std::make_unique<AsyncFaceDetector>(m_faceDetector.get());
+	}
 
+	bool skinInitialized = false;
+	if (resources.m_skinDetector)
+	{
+		skinInitialized = m_skinDetector.InitModel(*resources.m_skinDetector);
+	}
+	else
+	{
 #if 0
 #if (defined WIN32 || defined _WIN32 || defined WINCE || defined __CYGWIN__)
-    if (!SkinInit(m_skinDetector, m_appDirPath))
+		skinInitialized = SkinInit(m_skinDetector, m_appDirPath);
 #else
-    if (!SkinInit(m_skinDetector, "../beatmagnifier/data/"))
+		skinInitialized = SkinInit(m_skinDetector, "../beatmagnifier/data/");
 #endif
 #else
-    if (!SkinInit(m_skinDetector, m_appDirPath + "data" + PathSeparator()))
+		skinInitialized = SkinInit(m_skinDetector, m_appDirPath + "data" + PathSeparator());
 #endif
+	}
+    if (!skinInitialized)
     {
         m_settings.m_useSkinDetection = false;
     }
+	m_skinDetector.SetRefreshPeriod(m_settings.m_skinRefresh);
+	m_roiGrid.Init(m_settings.m_roiGrid, m_settings.m_fps);
 
 	if (m_signalProcessorColor.LoadPlugin(m_settings.m_signalLib))
 	{
-		InputParams inputParams;
-		inputParams.framesCount = m_settings.m_sampleSize;
-		inputParams.filterType = m_settings.m_filterType;
-		inputParams.signalNormalization = m_settings.m_signalNormalization;
-		inputParams.gauss_def_var = m_settings.m_gauss_def_var;
-		inputParams.gauss_min_var = m_settings.m_gauss_min_var;
-		inputParams.gauss_max_var = m_settings.m_gauss_max_var;
-		inputParams.gauss_eps = m_settings.m_gauss_eps;
-		inputParams.gauss_update_alpha = m_settings.m_gauss_update_alpha;
-		inputParams.gauss_proc_alpha = m_settings.m_gauss_proc_alpha;
-		inputParams.gauss_proc_weight_thresh = m_settings.m_gauss_proc_weight_thresh;
-		inputParams.retExpFreq = m_settings.m_return_exp_frequency;
-		inputParams.fps = static_cast<float>(m_settings.m_fps);
-
+		InputParams inputParams = MakeInputParams(m_settings);
 		m_signalProcessorColor.Init(&inputParams);
 	}
     
@@ -134,6 +184,20 @@ bool MainProcess::Init(const MeasureSettings& settings, const std::string& video
 		m_measureLogger.Init(videoName + "_measurements.csv");
 	}
 
+	m_traceWriter.Close();
+	if (!videoName.empty() && m_settings.m_saveTrace)
+	{
+		std::string traceName = videoName + "_trace.hrt";
+		if (!m_traceWriter.Open(traceName, m_settings.m_freq, m_settings.m_fps))
+		{
+			std::cerr << "Can't create " << traceName << std::endl;
+		}
+	}
+
+	m_subjects.clear();
+	m_subjectsInfo.clear();
+	m_nextSubjectId = 0;
+
 	m_frameInd = 0;
     return true;
 }
@@ -155,36 +219,61 @@ bool MainProcess::Process(
 	    bool createResultsPanno,
 	    bool showMixture)
 {
-    cv::UMat uframe = rgbFrame.getUMat(cv::ACCESS_READ);
+	m_pipelineResults = false;
 
-    // Детект лица
-    cv::Rect face = m_faceDetector->DetectBiggestFace(uframe);
-    // Tracking
-    if (m_currFaceRect.area() > 0)
-    {
-		if (face.area() == 0)
-		{
-			TrackFace(rgbFrame);
-		}
-		else
-		{
-			float iou = (face & m_currFaceRect).area() / static_cast<float>((face | m_currFaceRect).area());
-			if (iou < 0.4f)
-			{
-				TrackFace(rgbFrame);
-				face = cv::Rect();
-			}
-		}
-    }
-	if (face.area() > 16)
+	FrameResult frameData;
+	frameData.m_rgbFrame = rgbFrame;
+	frameData.m_captureTime = captureTime;
+	frameData.m_frameInd = m_frameInd;
+	frameData.m_drawResults = drawResults;
+	frameData.m_saveResults = saveResults;
+	frameData.m_createResultsPanno = createResultsPanno;
+	frameData.m_showMixture = showMixture;
+
+	if (m_settings.m_multiFace)
 	{
-		m_currFaceRect = face;
-		m_prevLandmarks.clear();
+		SubjectsStage(frameData);
+	}
+	else
+	{
+		DetectTrackStage(frameData);
+		RoiStage(frameData);
+		SignalStage(frameData);
+	}
+
+	imgProc = std::move(frameData.m_imgProc);
+	if (frameData.m_faceRect.area() > 0)
+	{
+		colorVal = frameData.m_colorVal;
+	}
+
+    ++m_frameInd;
+
+    return frameData.m_faceRect.area() > 0;
+}
+
+///
+/// \brief MainProcess::DetectTrackStage
+/// Face detection and tracking
+///
+void MainProcess::DetectTrackStage(FrameResult& frameData)
+{
+	cv::Mat rgbFrame = frameData.m_rgbFrame;
+
+	cv::Rect face;
+	if (m_asyncDetector)
+	{
+		DetectTrackAsync(rgbFrame, frameData.m_frameInd, face);
+	}
+	else
+	{
+		DetectTrackSync(rgbFrame, face);
 	}
+	m_detectScheduler.NextFrame();
+
     if (m_currFaceRect.empty())
     {
-        std::cout << "No face!" << std::endl;
-
+		m_detectScheduler.Reset();
 #if !USE_LK_TRACKER
 		if (m_faceTracker && !m_faceTracker.empty())
 		{
@@ -212,21 +301,197 @@ bool MainProcess::Process(
         }
     }
 
+	frameData.m_detectedRect = face;
+	frameData.m_faceRect = m_currFaceRect;
+	frameData.m_landmarks = m_prevLandmarks;
+
+#if USE_LK_TRACKER
+	// Own copy in the reused buffer: the results panno is drawn on the frame and the caller reuses the frame buffer
+	rgbFrame.copyTo(m_prevFrame);
+#endif
+}
+
+///
+/// \brief MainProcess::DetectTrackSync
+/// Face detection on the scheduled frames and tracking between them
+///
+void MainProcess::DetectTrackSync(cv::Mat rgbFrame, cv::Rect& face)
+{
+	bool trackAttempted = false;
+	bool tracked = false;
+	bool needDetection = m_currFaceRect.empty() || m_detectScheduler.NeedDetection();
+	if (!needDetection)
+	{
+		// Between the detections the face is only tracked
+		cv::Rect prevRect = m_currFaceRect;
+		trackAttempted = true;
+		tracked = TrackFace(rgbFrame);
+		if (tracked)
+		{
+			m_detectScheduler.Tracked(prevRect, m_currFaceRect);
+		}
+		else
+		{
+			// Tracker lost the face: detect it on this frame
+			needDetection = true;
+		}
+	}
+
+	if (needDetection)
+	{
+		cv::UMat uframe = rgbFrame.getUMat(cv::ACCESS_READ);
+
+		// Детект лица
+		face = m_faceDetector->DetectBiggestFace(uframe);
+		AcceptDetection(face, trackAttempted, tracked, rgbFrame);
+	}
+}
+
+///
+/// \brief MainProcess::DetectTrackAsync
+/// The face is tracked on every frame, the detector works in the separate thread.
+/// The detection result of the previous frame is moved on the current frame with the tracker motion
+///
+void MainProcess::DetectTrackAsync(cv::Mat rgbFrame, int frameInd, cv::Rect& face)
+{
+	int detectInd = 0;
+	if (m_currFaceRect.empty())
+	{
+		// Nothing to track: wait for detection on the current frame
+		m_trackHistory.clear();
+		m_asyncDetector->GetResult(face, detectInd, true);
+		m_asyncDetector->Submit(rgbFrame, frameInd);
+		m_asyncDetector->GetResult(face, detectInd, true);
+		AcceptDetection(face, true, false, rgbFrame);
+	}
+	else
+	{
+		cv::Rect prevRect = m_currFaceRect;
+		bool tracked = TrackFace(rgbFrame);
+		if (tracked)
+		{
+			m_detectScheduler.Tracked(prevRect, m_currFaceRect);
+		}
+		else
+		{
+			m_detectScheduler.Reset();
+		}
+
+		if (m_asyncDetector->GetResult(face, detectInd, false))
+		{
+			// Without tracking the detection can't be moved on the current frame, it is used as is
+			if (tracked && !face.empty())
+			{
+				// Face position on the detection frame and on the current frame
+				auto it = std::find_if(m_trackHistory.begin(), m_trackHistory.end(), [detectInd](const std::pair<int, cv::Rect>& v) { return v.first == detectInd; });
+				if (it != m_trackHistory.end() && !it->second.empty())
+				{
+					const cv::Rect& histRect = it->second;
+					double scale = m_currFaceRect.width / static_cast<double>(histRect.width);
+					cv::Point2d center(face.x + face.width / 2. + (m_currFaceRect.x + m_currFaceRect.width / 2.) - (histRect.x + histRect.width / 2.),
+									   face.y + face.height / 2. + (m_currFaceRect.y + m_currFaceRect.height / 2.) - (histRect.y + histRect.height / 2.));
+					cv::Size2d size(scale * face.width, scale * face.height);
+					face = cv::Rect(cvRound(center.x - size.width / 2.), cvRound(center.y - size.height / 2.), cvRound(size.width), cvRound(size.height));
+				}
+			}
+			AcceptDetection(face, true, tracked, rgbFrame);
+		}
+		else if (!tracked)
+		{
+			// Tracker lost the face and there is no detection: the stale rect isn't measured,
+			// the next frame waits for the detection
+			m_currFaceRect = cv::Rect();
+		}
+
+		if (m_detectScheduler.NeedDetection())
+		{
+			m_asyncDetector->Submit(rgbFrame, frameInd);
+		}
+	}
+
+	m_trackHistory.emplace_back(frameInd, m_currFaceRect);
+	if (m_trackHistory.size() > MaxTrackHistory)
+	{
+		m_trackHistory.pop_front();
+	}
+}
+
+///
+/// \brief MainProcess::AcceptDetection
+/// Compare the detection result with tracking and reinit tracker
+/// \param face - detection result, it is cleared if the tracked face is used
+/// \param trackAttempted - the tracker was already updated on this frame: the second update would re-learn
+///                         the template on the failed frame, so the tracker runs at most once per frame
+/// \param tracked - result of that update
+///
+void MainProcess::AcceptDetection(cv::Rect& face, bool trackAttempted, bool tracked, cv::Mat rgbFrame)
+{
+	// Tracking
+	if (m_currFaceRect.area() > 0)
+	{
+		bool matched = false;
+		if (face.area() > 0)
+		{
+			float iou = (face & m_currFaceRect).area() / static_cast<float>((face | m_currFaceRect).area());
+			matched = (iou >= 0.4f);
+		}
+		if (!matched)
+		{
+			if (!trackAttempted)
+			{
+				tracked = TrackFace(rgbFrame);
+			}
+			if (tracked)
+			{
+				// The tracked face is used instead of the not matched detection
+				face = cv::Rect();
+			}
+			else if (face.area() <= 16)
+			{
+				// Both tracker and detector lost the face: the stale rect isn't measured
+				m_currFaceRect = cv::Rect();
+			}
+		}
+	}
+	m_detectScheduler.Detected(face, m_currFaceRect);
+
+	if (face.area() > 16)
+	{
+		m_currFaceRect = face;
+		m_prevLandmarks.clear();
+#if !USE_LK_TRACKER
+		// Tracker is initialized on the detection frame and will be updated on the next frame
+		InitFaceTracker(rgbFrame);
+#endif
+	}
+}
+
+///
+/// \brief MainProcess::MotionAmplification
+/// Motion amplification on the face crop or on the whole frame if faceRect is empty
+///
+void MainProcess::MotionAmplification(FrameResult& frameData, const cv::Rect& faceRect)
+{
+	cv::Mat rgbFrame = frameData.m_rgbFrame;
+	cv::Mat& imgProc = frameData.m_imgProc;
+	frameData.m_procRect = cv::Rect(0, 0, rgbFrame.cols, rgbFrame.rows);
+
 	if (m_settings.m_useMA)
 	{
 		//std::cout << "Start MA" << std::endl;
-		if (m_settings.m_maUseCrop && m_currFaceRect.area() > 0)
+		if (m_settings.m_maUseCrop && faceRect.area() > 0)
 		{
 			//std::cout << "New face" << std::endl;
-			cv::Rect crop = m_faceCrop.NewFace(m_currFaceRect, rgbFrame.size());
+			cv::Rect crop = m_faceCrop.NewFace(faceRect, rgbFrame.size());
+			rgbFrame(crop).copyTo(m_maInput);
 
-			//std::cout << "Face rect = " << m_currFaceRect << ", MA crop = " << crop << ", frame size = " << rgbFrame.size() << std::endl;
+			//std::cout << "Face rect = " << faceRect << ", MA crop = " << crop << ", frame size = " << rgbFrame.size() << std::endl;
 
 			if (!m_eulerianMA->IsInitialized() || m_eulerianMA->GetSize() != crop.size())
 			{
 				//std::cout << "MA init" << std::endl;
 
-				m_eulerianMA->Init(uframe(crop),
+				m_eulerianMA->Init(m_maInput,
 					m_settings.m_maAlpha, m_settings.m_maLambdaC,
 					m_settings.m_maFlow, m_settings.m_maFhight,
 					cvRound(m_settings.m_fps), m_settings.m_maChromAttenuation);
@@ -236,18 +501,32 @@ bool MainProcess::Process(
 			{
 				//std::cout << "MA Process" << std::endl;
 
-				cv::UMat output = m_eulerianMA->Process(uframe(crop));
-				rgbFrame.copyTo(imgProc);
-				output.convertTo(imgProc(crop), CV_8UC3);
+				cv::UMat output = m_eulerianMA->Process(m_maInput);
+				if (m_settings.m_cropOnly && !frameData.m_drawResults && !frameData.m_createResultsPanno)
+				{
+					// Nobody will see the frame: only the crop is processed
+					imgProc = m_framePool.Get(crop.size(), CV_8UC3);
+					output.convertTo(imgProc, CV_8UC3);
+					frameData.m_procRect = crop;
+				}
+				else
+				{
+					// Only the pixels out of the crop are copied from the input frame
+					imgProc = m_framePool.Get(rgbFrame.size(), CV_8UC3);
+					CopyOutside(rgbFrame, imgProc, crop);
+					output.convertTo(imgProc(crop), CV_8UC3);
+				}
 			}
 		}
 		else
 		{
-			if (!m_eulerianMA->IsInitialized() || m_eulerianMA->GetSize() != uframe.size())
+			// The same upload buffer as for the crop: UMat isn't allocated on every frame
+			rgbFrame.copyTo(m_maInput);
+			if (!m_eulerianMA->IsInitialized() || m_eulerianMA->GetSize() != m_maInput.size())
 			{
 				//std::cout << "MA init" << std::endl;
 
-				m_eulerianMA->Init(uframe,
+				m_eulerianMA->Init(m_maInput,
 					m_settings.m_maAlpha, m_settings.m_maLambdaC,
 					m_settings.m_maFlow, m_settings.m_maFhight,
 					cvRound(m_settings.m_fps), m_settings.m_maChromAttenuation);
@@ -257,7 +536,8 @@ bool MainProcess::Process(
 			{
 				//std::cout << "MA Process" << std::endl;
 
-				cv::UMat output = m_eulerianMA->Process(uframe);
+				cv::UMat output = m_eulerianMA->Process(m_maInput);
+				imgProc = m_framePool.Get(rgbFrame.size(), CV_8UC3);
 				output.convertTo(imgProc, CV_8UC3);
 			}
 		}
@@ -266,55 +546,427 @@ bool MainProcess::Process(
 	{
 		imgProc = rgbFrame;
 	}
+}
+
+///
+/// \brief MainProcess::RoiStage
+/// Motion amplification, skin detection and color value of the face
+///
+void MainProcess::RoiStage(FrameResult& frameData)
+{
+	cv::Mat rgbFrame = frameData.m_rgbFrame;
+	const cv::Rect& faceRect = frameData.m_faceRect;
+
+	MotionAmplification(frameData, faceRect);
 
     // Если есть объект ненулевой площади вычисляем среднее по цвету
-    if (m_currFaceRect.area() > 0)
+    if (faceRect.area() > 0)
     {
 		//std::cout << "Skin detection" << std::endl;
         cv::Mat skinMask;
         if (m_settings.m_useSkinDetection)
         {
-            skinMask = m_skinDetector.Detect(rgbFrame(m_currFaceRect), drawResults, saveResults, m_frameInd);
+			if (frameData.m_detectedRect.area() > 0)
+			{
+				m_skinDetector.Refresh();
+			}
+            skinMask = m_skinDetector.Detect(rgbFrame(faceRect), frameData.m_drawResults, frameData.m_saveResults, frameData.m_frameInd);
         }
 		//std::cout << "Skin mean" << std::endl;
 
-		if (m_settings.m_calcMean)
+		// View of the face on the processed image
+		cv::Mat procFace = frameData.m_imgProc(faceRect - frameData.m_procRect.tl());
+		if (m_settings.m_calcMean && m_settings.m_roiGrid > 1)
 		{
-			colorVal = cv::mean(imgProc(m_currFaceRect), skinMask.empty() ? cv::noArray() : skinMask);
+			m_roiGrid.Process(procFace, skinMask, frameData.m_colorVal);
 		}
 		else
 		{
-			std::vector<cv::Mat> chans;
-			cv::split(imgProc(m_currFaceRect), chans);
-			colorVal[0] = MedianMat(chans[0], 256);
-			colorVal[1] = MedianMat(chans[1], 256);
-			colorVal[2] = MedianMat(chans[2], 256);
+			ColorStats stats;
+			CalcColorStats(procFace, skinMask, stats);
+			frameData.m_colorVal = m_settings.m_calcMean ? stats.m_mean : stats.m_median;
 		}
-		//std::cout << "SP add measure" << std::endl;
-        m_signalProcessorColor.AddMeasure(captureTime, colorVal.val);
-		//std::cout << "SP measure" << std::endl;
-		m_signalProcessorColor.MeasureFrequency(m_settings.m_freq, m_frameInd, showMixture);
-		if (createResultsPanno)
+
+		if (frameData.m_createResultsPanno)
 		{
 			//std::cout << "Calc mm" << std::endl;
 			if (!skinMask.empty())
 			{
-				CalcMotionMap(rgbFrame, skinMask, m_currFaceRect);
+				CalcMotionMap(rgbFrame, skinMask, faceRect);
 			}
 			//std::cout << "Draw result" << std::endl;
-			DrawResult(rgbFrame, face, m_currFaceRect, m_prevLandmarks);
+			DrawResult(rgbFrame, frameData.m_detectedRect, faceRect, frameData.m_landmarks);
 		}
 	}
-    else
-    {
-        m_signalProcessorColor.Reset();
-    }
+	else
+	{
+		m_roiGrid.Reset();
+	}
+}
 
-    ++m_frameInd;
+///
+/// \brief MainProcess::SignalStage
+/// Send the color value to the signal plugin
+///
+void MainProcess::SignalStage(FrameResult& frameData)
+{
+	std::lock_guard<std::mutex> lock(m_signalMutex);
+
+	if (m_traceWriter.IsOpened())
+	{
+		ColorTraceRecord record;
+		record.m_captureTime = frameData.m_captureTime;
+		record.m_x = frameData.m_faceRect.x;
+		record.m_y = frameData.m_faceRect.y;
+		record.m_width = frameData.m_faceRect.width;
+		record.m_height = frameData.m_faceRect.height;
+		if (frameData.m_faceRect.area() > 0)
+		{
+			record.m_flags |= ColorTraceRecord::FaceFound;
+			std::copy(frameData.m_colorVal.val, frameData.m_colorVal.val + 3, record.m_rgb);
+			if (m_settings.m_useSkinDetection)
+			{
+				record.m_flags |= ColorTraceRecord::SkinMask;
+			}
+		}
+		if (frameData.m_detectedRect.area() > 0)
+		{
+			record.m_flags |= ColorTraceRecord::Detected;
+		}
+		m_traceWriter.Write(record);
+	}
+
+	// Without the plugin only the colour trace is written
+	if (!m_signalProcessorColor.IsLoaded())
+	{
+		return;
+	}
+
+	if (frameData.m_faceRect.area() > 0)
+	{
+		//std::cout << "SP add measure" << std::endl;
+		m_signalProcessorColor.AddMeasure(frameData.m_captureTime, frameData.m_colorVal.val);
+		//std::cout << "SP measure" << std::endl;
+		m_signalProcessorColor.MeasureFrequency(m_settings.m_freq, frameData.m_frameInd, frameData.m_showMixture);
+	}
+	else
+	{
+		m_signalProcessorColor.Reset();
+	}
+
+	if (m_pipelineMode)
+	{
+		// The caller reads the results later, when the plugin already works with the next frames
+		frameData.m_remainingMeasurements = m_signalProcessorColor.RemainingMeasurements();
+		if (frameData.m_remainingMeasurements == 0)
+		{
+			m_signalProcessorColor.GetFrequency(&frameData.m_freqResults);
+			m_measureLogger.NewMeasure(frameData.m_frameInd, frameData.m_freqResults.smootFreq);
+		}
+	}
+}
+
+///
+/// \brief MainProcess::SubjectsStage
+/// Multi face mode: detection on the whole frame is shared, tracking and measurement of every subject work in parallel
+///
+void MainProcess::SubjectsStage(FrameResult& frameData)
+{
+	cv::Mat rgbFrame = frameData.m_rgbFrame;
+	const int subjectsCount = static_cast<int>(m_subjects.size());
+
+	// Tracking
+	m_subjectsTracked.assign(m_subjects.size(), 0);
+	m_subjectsPrevRects.resize(m_subjects.size());
+	cv::parallel_for_(cv::Range(0, subjectsCount), [&](const cv::Range& range)
+	{
+		for (int i = range.start; i < range.end; ++i)
+		{
+			m_subjectsPrevRects[i] = m_subjects[i]->GetFaceRect();
+			m_subjectsTracked[i] = m_subjects[i]->Track(rgbFrame) ? 1 : 0;
+		}
+	});
+	bool subjectLost = false;
+	for (int i = 0; i < subjectsCount; ++i)
+	{
+		if (m_subjectsTracked[i])
+		{
+			m_detectScheduler.Tracked(m_subjectsPrevRects[i], m_subjects[i]->GetFaceRect());
+		}
+		else
+		{
+			subjectLost = true;
+		}
+	}
+
+	// Detection
+	if (m_subjects.empty() || subjectLost || m_detectScheduler.NeedDetection())
+	{
+		cv::UMat uframe = rgbFrame.getUMat(cv::ACCESS_READ);
+		m_faceDetector->DetectAllFaces(uframe, m_detectedFaces);
+		MatchSubjects(rgbFrame);
+		m_detectScheduler.Detected(m_detectedFaces.empty() ? cv::Rect() : m_detectedFaces[0], cv::Rect());
+	}
+	m_detectScheduler.NextFrame();
+
+	m_subjects.erase(std::remove_if(m_subjects.begin(), m_subjects.end(), [](const std::unique_ptr<FaceSubject>& subject)
+	{
+		return subject->MissedFrames() > MaxMissedFrames;
+	}), m_subjects.end());
+
+	// Motion amplification on the whole frame and measurement
+	MotionAmplification(frameData, cv::Rect());
+	cv::Mat imgProc = frameData.m_imgProc;
+	cv::parallel_for_(cv::Range(0, static_cast<int>(m_subjects.size())), [&](const cv::Range& range)
+	{
+		for (int i = range.start; i < range.end; ++i)
+		{
+			m_subjects[i]->Process(rgbFrame, imgProc, frameData.m_captureTime, frameData.m_frameInd);
+		}
+	});
+
+	m_subjectsInfo.clear();
+	int mainInd = -1;
+	for (const auto& subject : m_subjects)
+	{
+		m_subjectsInfo.push_back(subject->GetInfo());
+		const SubjectInfo& info = m_subjectsInfo.back();
+		if (!info.m_found)
+		{
+			continue;
+		}
+		if (mainInd < 0)
+		{
+			mainInd = static_cast<int>(m_subjectsInfo.size()) - 1;
+		}
+
+		if (frameData.m_createResultsPanno)
+		{
+			cv::rectangle(rgbFrame, info.m_faceRect, cv::Scalar(0, 200, 0), 1, cv::LINE_AA, 0);
+			cv::putText(rgbFrame, std::to_string(info.m_id), info.m_faceRect.tl(), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 200, 0));
+		}
+	}
+
+	// The first found subject is returned as the main face
+	m_currFaceRect = (mainInd < 0) ? cv::Rect() : m_subjectsInfo[mainInd].m_faceRect;
+	frameData.m_detectedRect = m_currFaceRect;
+	frameData.m_faceRect = m_currFaceRect;
+	if (mainInd >= 0)
+	{
+		const SubjectInfo& mainInfo = m_subjectsInfo[mainInd];
+		frameData.m_colorVal = mainInfo.m_colorVal;
+		frameData.m_remainingMeasurements = mainInfo.m_remainingMeasurements;
+		frameData.m_freqResults = mainInfo.m_freqResults;
+	}
+}
+
+///
+/// \brief MainProcess::MatchSubjects
+/// Greedy matching of the detected faces with subjects by IoU, new subjects for the not matched faces
+///
+void MainProcess::MatchSubjects(cv::Mat rgbFrame)
+{
+	struct MatchPair
+	{
+		float m_iou;
+		size_t m_subject;
+		size_t m_face;
+	};
+	std::vector<MatchPair> pairs;
+	for (size_t si = 0; si < m_subjects.size(); ++si)
+	{
+		const cv::Rect& subjectRect = m_subjects[si]->GetFaceRect();
+		for (size_t fi = 0; fi < m_detectedFaces.size(); ++fi)
+		{
+			const cv::Rect& face = m_detectedFaces[fi];
+			float iou = (face & subjectRect).area() / static_cast<float>((face | subjectRect).area());
+			if (iou > 0.3f)
+			{
+				pairs.push_back({ iou, si, fi });
+			}
+		}
+	}
+	std::sort(pairs.begin(), pairs.end(), [](const MatchPair& p1, const MatchPair& p2) { return p1.m_iou > p2.m_iou; });
+
+	std::vector<uchar> subjectMatched(m_subjects.size(), 0);
+	std::vector<uchar> faceMatched(m_detectedFaces.size(), 0);
+	for (const auto& pair : pairs)
+	{
+		if (!subjectMatched[pair.m_subject] && !faceMatched[pair.m_face])
+		{
+			m_subjects[pair.m_subject]->Detected(m_detectedFaces[pair.m_face], rgbFrame);
+			subjectMatched[pair.m_subject] = 1;
+			faceMatched[pair.m_face] = 1;
+		}
+	}
+	for (size_t si = 0; si < subjectMatched.size(); ++si)
+	{
+		if (!subjectMatched[si])
+		{
+			m_subjects[si]->Missed();
+		}
+	}
+	for (size_t fi = 0; fi < faceMatched.size(); ++fi)
+	{
+		if (!faceMatched[fi] && m_detectedFaces[fi].area() > 16 && static_cast<int>(m_subjects.size()) < m_settings.m_maxSubjects)
+		{
+			std::unique_ptr<FaceSubject> subject = std::make_unique<FaceSubject>(m_nextSubjectId, m_detectedFaces[fi]);
+			if (subject->Init(m_settings, m_skinDetector))
+			{
+				subject->Detected(m_detectedFaces[fi], rgbFrame);
+				m_subjects.push_back(std::move(subject));
+				++m_nextSubjectId;
+			}
+		}
+	}
+}
+
+///
+/// \brief MainProcess::StartPipeline
+/// \param queueSize - capacity of the queues between stages
+///
+bool MainProcess::StartPipeline(size_t queueSize)
+{
+	if (m_pipelineMode)
+	{
+		return true;
+	}
+	if (!m_faceDetector || !m_eulerianMA)
+	{
+		return false;
+	}
+	if (m_settings.m_multiFace)
+	{
+		std::cout << "Pipeline mode is not supported with multi face measurement" << std::endl;
+		return false;
+	}
+
+	m_detectQueue = std::make_unique<FramesQueue>(queueSize);
+	m_roiQueue = std::make_unique<FramesQueue>(queueSize);
+	m_signalQueue = std::make_unique<FramesQueue>(queueSize);
+	m_resultsQueue = std::make_unique<FramesQueue>(queueSize);
+
+	m_pipelineMode = true;
+	m_pipelineResults = true;
+	m_resultFaceRect = cv::Rect();
+	m_resultLandmarks.clear();
+	m_resultFrameInd = 0;
 
-	m_prevFrame = rgbFrame;
+	m_pipelineThreads.emplace_back(&MainProcess::StageThread, this, m_detectQueue.get(), m_roiQueue.get(), &MainProcess::DetectTrackStage);
+	m_pipelineThreads.emplace_back(&MainProcess::StageThread, this, m_roiQueue.get(), m_signalQueue.get(), &MainProcess::RoiStage);
+	m_pipelineThreads.emplace_back(&MainProcess::StageThread, this, m_signalQueue.get(), m_resultsQueue.get(), &MainProcess::SignalStage);
 
-    return m_currFaceRect.area() > 0;
+	return true;
+}
+
+///
+/// \brief MainProcess::StopPipeline
+/// \param processAll - process all frames that are already in the pipeline (they can be popped after stop) or drop them
+///
+void MainProcess::StopPipeline(bool processAll)
+{
+	if (!m_pipelineMode)
+	{
+		return;
+	}
+
+	m_detectQueue->Close();
+
+	std::vector<FrameResult> tail;
+	if (processAll)
+	{
+		// The results queue is bounded: read it while the stages finish the remaining frames
+		FrameResult frameData;
+		while (m_resultsQueue->Pop(frameData, true))
+		{
+			tail.emplace_back(std::move(frameData));
+		}
+	}
+	else
+	{
+		m_roiQueue->Close();
+		m_signalQueue->Close();
+		m_resultsQueue->Close();
+	}
+
+	for (auto& thread : m_pipelineThreads)
+	{
+		thread.join();
+	}
+	m_pipelineThreads.clear();
+
+	m_resultsQueue = std::make_unique<FramesQueue>(tail.size() + 1);
+	for (auto& frameData : tail)
+	{
+		m_resultsQueue->Push(std::move(frameData));
+	}
+	m_resultsQueue->Close();
+
+	m_pipelineMode = false;
+}
+
+///
+/// \brief MainProcess::IsPipelineStarted
+///
+bool MainProcess::IsPipelineStarted() const
+{
+	return m_pipelineMode;
+}
+
+///
+/// \brief MainProcess::PushFrame
+///
+bool MainProcess::PushFrame(cv::Mat rgbFrame, int64 captureTime, bool saveResults, bool createResultsPanno)
+{
+	if (!m_pipelineMode)
+	{
+		return false;
+	}
+
+	FrameResult frameData;
+	frameData.m_rgbFrame = std::move(rgbFrame);
+	frameData.m_captureTime = captureTime;
+	frameData.m_frameInd = m_frameInd++;
+	// HighGUI windows can not be used from the stage threads
+	frameData.m_drawResults = false;
+	frameData.m_showMixture = false;
+	frameData.m_saveResults = saveResults;
+	frameData.m_createResultsPanno = createResultsPanno;
+
+	return m_detectQueue->Push(std::move(frameData));
+}
+
+///
+/// \brief MainProcess::PopResult
+///
+bool MainProcess::PopResult(FrameResult& result, bool wait)
+{
+	if (!m_resultsQueue || !m_resultsQueue->Pop(result, wait))
+	{
+		return false;
+	}
+	// The stage threads already work with the next frames: Get* functions return the state of this result
+	m_resultFaceRect = result.m_faceRect;
+	m_resultLandmarks = result.m_landmarks;
+	m_resultFrameInd = result.m_frameInd;
+	return true;
+}
+
+///
+/// \brief MainProcess::StageThread
+///
+void MainProcess::StageThread(FramesQueue* inQueue, FramesQueue* outQueue, void (MainProcess::*stage)(FrameResult&))
+{
+	FrameResult frameData;
+	while (inQueue->Pop(frameData, true))
+	{
+		(this->*stage)(frameData);
+		if (!outQueue->Push(std::move(frameData)))
+		{
+			break;
+		}
+	}
+	outQueue->Close();
 }
 
 ///
@@ -323,6 +975,8 @@ bool MainProcess::Process(
 ///
 bool MainProcess::DrawSignal(cv::Mat& signalPlot, bool drawSignal, bool saveSignal)
 {
+	std::lock_guard<std::mutex> lock(m_signalMutex);
+
 	SignalInfo signalInfo;
 	bool res = m_signalProcessorColor.GetSignal(&signalInfo);
 	if (res && signalInfo.m_signal[0])
@@ -383,7 +1037,7 @@ bool MainProcess::DrawSignal(cv::Mat& signalPlot, bool drawSignal, bool saveSign
 			}
 			if (saveSignal)
 			{
-				std::string fileName = "signal_color/" + std::to_string(m_frameInd) + ".png";
+				std::string fileName = "signal_color/" + std::to_string(CurrentFrameInd()) + ".png";
 				cv::imwrite(fileName, signalPlot);
 			}
 		}
@@ -407,6 +1061,8 @@ bool MainProcess::DrawFrequency(cv::Mat& freqPlot)
 	{
 		freqPlot.setTo(0);
 
+		std::lock_guard<std::mutex> lock(m_signalMutex);
+
 		SignalInfo signalInfo;
 		res = m_signalProcessorColor.GetSignal(&signalInfo);
 		if (res && signalInfo.m_spectrum[0])
@@ -552,7 +1208,17 @@ void MainProcess::CalcMotionMap(cv::Mat frame,
 ///
 cv::Rect MainProcess::GetFaceRect() const
 {
-    return m_currFaceRect;
+	// m_currFaceRect is written by the detection stage thread in the pipeline mode
+	return m_pipelineResults ? m_resultFaceRect : m_currFaceRect;
+}
+
+///
+/// \brief MainProcess::GetSubjects
+/// \return
+///
+const std::vector<SubjectInfo>& MainProcess::GetSubjects() const
+{
+	return m_subjectsInfo;
 }
 
 ///
@@ -560,8 +1226,14 @@ cv::Rect MainProcess::GetFaceRect() const
 ///
 void MainProcess::GetFrequency(FrequencyResults* freqResults, double* meanFreq, double* devFreq)
 {
+	std::lock_guard<std::mutex> lock(m_signalMutex);
+
 	m_signalProcessorColor.GetFrequency(freqResults);
-	m_measureLogger.NewMeasure(m_frameInd, freqResults->smootFreq);
+	// In the pipeline mode the measures are logged by the signal stage
+	if (!m_pipelineResults)
+	{
+		m_measureLogger.NewMeasure(m_frameInd, freqResults->smootFreq);
+	}
 	if (meanFreq && devFreq)
 	{
 		m_measureLogger.GetMeanStdDev(*meanFreq, *devFreq);
@@ -574,7 +1246,25 @@ void MainProcess::GetFrequency(FrequencyResults* freqResults, double* meanFreq,
 ///
 const std::vector<cv::Point2f>& MainProcess::GetCurrLandmarks() const
 {
-    return m_prevLandmarks;
+	return m_pipelineResults ? m_resultLandmarks : m_prevLandmarks;
+}
+
+///
+/// \brief MainProcess::CurrentFrameInd
+/// \return Index of the last processed frame or of the last popped result in the pipeline mode
+///
+int MainProcess::CurrentFrameInd() const
+{
+	return m_pipelineResults ? m_resultFrameInd : m_frameInd;
+}
+
+///
+/// \brief MainProcess::GetFramePool
+/// \return
+///
+FramePool& MainProcess::GetFramePool()
+{
+	return m_framePool;
 }
 
 ///
@@ -583,9 +1273,46 @@ const std::vector<cv::Point2f>& MainProcess::GetCurrLandmarks() const
 ///
 int MainProcess::RemainingMeasurements()
 {
+	std::lock_guard<std::mutex> lock(m_signalMutex);
+
 	return m_signalProcessorColor.RemainingMeasurements();
 }
 
+#if !USE_LK_TRACKER
+///
+/// \brief MainProcess::InitFaceTracker
+/// \param rgbFrame - frame with m_currFaceRect
+///
+void MainProcess::InitFaceTracker(cv::Mat rgbFrame)
+{
+	// TrackerKCF::init asserts on the empty box: the face rect outside the frame is lost
+	cv::Rect rect = m_currFaceRect & cv::Rect(0, 0, rgbFrame.cols - 1, rgbFrame.rows - 1);
+	if (rect.area() <= 0)
+	{
+		m_faceTracker.release();
+		m_currFaceRect = cv::Rect();
+		return;
+	}
+
+	cv::TrackerKCF::Params params;
+	params.compressed_size = 1;
+	params.desc_pca = cv::TrackerKCF::CN;
+	params.desc_npca = cv::TrackerKCF::CN;
+	params.resize = true;
+	params.detect_thresh = 0.5f;
+	m_faceTracker = cv::TrackerKCF::create(params);
+
+	// KCF copies the input image on every update: in the crop_only mode it gets only the padded face.
+	// The region is fixed until the next detection, so the tracker coordinates stay valid
+	m_trackRegion = cv::Rect(0, 0, rgbFrame.cols, rgbFrame.rows);
+	if (m_settings.m_cropOnly)
+	{
+		m_trackRegion &= cv::Rect(rect.x - rect.width, rect.y - rect.height, 3 * rect.width, 3 * rect.height);
+	}
+	m_faceTracker->init(rgbFrame(m_trackRegion), cv::Rect2d(rect.x - m_trackRegion.x, rect.y - m_trackRegion.y, rect.width, rect.height));
+}
+#endif
+
 ///
 /// \brief MainProcess::TrackFace
 /// \return
@@ -636,27 +1363,27 @@ bool MainProcess::TrackFace(cv::Mat rgbFrame)
 #else
 	if (!m_faceTracker || m_faceTracker.empty())
 	{
-		cv::TrackerKCF::Params params;
-		params.compressed_size = 1;
-		params.desc_pca = cv::TrackerKCF::CN;
-		params.desc_npca = cv::TrackerKCF::CN;
-		params.resize = true;
-		params.detect_thresh = 0.5f;
-		m_faceTracker = cv::TrackerKCF::create(params);
-
-		m_faceTracker->init(m_prevFrame, cv::Rect2d(m_currFaceRect.x, m_currFaceRect.y, m_currFaceRect.width, m_currFaceRect.height));
+		return false;
 	}
-	else
+	// The frame size was changed after the tracker initialization
+	if ((m_trackRegion & cv::Rect(0, 0, rgbFrame.cols, rgbFrame.rows)) != m_trackRegion)
 	{
-		cv::Rect2d newRect;
-		if (m_faceTracker->update(rgbFrame, newRect))
-		{
-			m_currFaceRect.x = static_cast<int>(newRect.x);
-			m_currFaceRect.y = static_cast<int>(newRect.y);
-			m_currFaceRect.width = static_cast<int>(newRect.width);
-			m_currFaceRect.height = static_cast<int>(newRect.height);
-		}
+		return false;
+	}
+	// Tracker was initialized on the detection frame, the previous frame isn't needed
+	cv::Rect2d newRect;
+	if (!m_faceTracker->update(rgbFrame(m_trackRegion), newRect))
+	{
+		return false;
+	}
+	cv::Rect trackedRect(static_cast<int>(newRect.x) + m_trackRegion.x, static_cast<int>(newRect.y) + m_trackRegion.y,
+						 static_cast<int>(newRect.width), static_cast<int>(newRect.height));
+	if (m_settings.m_cropOnly && (trackedRect & m_trackRegion) != trackedRect)
+	{
+		// The face left the tracking region: it is detected again on this frame
+		return false;
 	}
+	m_currFaceRect = trackedRect;
 #endif
 	return !m_currFaceRect.empty();
 }
@@ -4,20 +4,69 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <thread>
+#include <mutex>
 
 #include "SignalPlugin.h"
+#include "FaceSubject.h"
+#include "RoiGrid.h"
 
 #include "../detect_track/FaceDetector.h"
 #include "../detect_track/SkinDetector.h"
 #include "../detect_track/LKTracker.h"
+#include "../detect_track/DetectionScheduler.h"
 #include "../eulerian_ma/MotionAmp.h"
 #include "../common/common.h"
+#include "../common/BoundedQueue.h"
+#include "../common/ColorTrace.h"
+#include "../common/FramePool.h"
 
 #include <opencv2/core/ocl.hpp>
 #include <opencv2/tracking.hpp>
 
 #define USE_LK_TRACKER 0
 
+///
+/// \brief The FrameResult struct
+/// All data of the one frame that moves through the processing stages
+/// It is moved between the stages, the frames are never copied: m_imgProc is the buffer of the MainProcess frame pool
+/// and it returns to the pool when the result is released
+///
+struct FrameResult
+{
+	cv::Mat m_rgbFrame;                   // Input frame (results panno is drawn on it)
+	cv::Mat m_imgProc;                    // Frame after motion amplification
+	cv::Rect m_procRect;                  // Part of the frame in m_imgProc: the whole frame or the face crop in the crop_only mode
+	int64 m_captureTime = 0;
+	int m_frameInd = 0;
+
+	bool m_drawResults = false;
+	bool m_saveResults = false;
+	bool m_createResultsPanno = false;
+	bool m_showMixture = false;
+
+	cv::Rect m_detectedRect;              // Face detector result on this frame
+	cv::Rect m_faceRect;                  // Face rect after tracking
+	std::vector<cv::Point2f> m_landmarks;
+	cv::Scalar m_colorVal;
+
+	int m_remainingMeasurements = 0;      // Filled only in the pipeline mode
+	FrequencyResults m_freqResults;       // Filled only in the pipeline mode when m_remainingMeasurements == 0
+};
+
+///
+/// \brief The SharedResources struct
+/// Models are loaded once and shared by the MainProcess instances of the many streams
+///
+struct SharedResources
+{
+	std::shared_ptr<FaceDetectorBase> m_faceDetector; // Thread safe PerThreadFaceDetector: own detector for every thread
+	std::shared_ptr<SkinDetector> m_skinDetector;     // Only the model is used, every stream has own skin mask
+
+	/// appDirPath must be ended with the path separator
+	bool Init(const MeasureSettings& settings, const std::string& appDirPath);
+};
+
 ///
 /// \brief The MainProcess class
 ///
@@ -28,9 +77,28 @@ public:
     ~MainProcess();
 
     bool Init(const MeasureSettings& settings, const std::string& videoName);
+	bool Init(const MeasureSettings& settings, const std::string& videoName, const SharedResources& resources);
+	/// imgProc is the face crop only in the crop_only mode without drawResults and createResultsPanno, otherwise it is the whole frame.
+	/// imgProc is the output only: it is the buffer from the frame pool or rgbFrame itself without the motion amplification
     bool Process(cv::Mat rgbFrame, cv::Mat& imgProc, int64 captureTime, cv::Scalar& colorVal, bool drawResults, bool saveResults, bool createResultsPanno, bool showMixture);
 
+	///
+	/// Pipeline mode: detection/tracking, ROI processing and signal processing work in the separate threads
+	/// Frames go through the stages in the input order, the results are returned with the same captureTime
+	///
+	bool StartPipeline(size_t queueSize);
+	void StopPipeline(bool processAll);
+	bool IsPipelineStarted() const;
+	/// Blocks while the pipeline is full. The frame is moved to the pipeline, its buffer must not be reused by the caller
+	bool PushFrame(cv::Mat rgbFrame, int64 captureTime, bool saveResults, bool createResultsPanno);
+	/// Returns false if no result is ready (wait == false) or the pipeline was stopped and all results were popped.
+	/// After the pipeline start GetFaceRect, GetCurrLandmarks, GetFrequency and DrawSignal refer to the last popped result,
+	/// they must be called from the thread of PushFrame and PopResult
+	bool PopResult(FrameResult& result, bool wait);
+
     cv::Rect GetFaceRect() const;
+	/// Multi face mode: results for all tracked persons
+	const std::vector<SubjectInfo>& GetSubjects() const;
     void GetFrequency(FrequencyResults* freqResults, double* meanFreq = nullptr, double* devFreq = nullptr);
     const std::vector<cv::Point2f>& GetCurrLandmarks() const;
 	int RemainingMeasurements();
@@ -38,23 +106,36 @@ public:
 	bool DrawSignal(cv::Mat& signalPlot, bool drawSignal, bool saveSignal);
 	bool DrawFrequency(cv::Mat& freqPlot);
 
+	/// Pool of the processed frames, the caller can take from it the capture frames and the plots
+	FramePool& GetFramePool();
+
 private:
 	std::string m_appDirPath;
     cv::Rect m_currFaceRect;
     std::vector<cv::Point2f> m_prevLandmarks;
-	cv::Mat m_prevFrame;
+	cv::Mat m_prevFrame;                  // Copy for the LK tracker, KCF trackers are initialized on the detection frame
 
 	StatisticLogger<double> m_measureLogger;
-
-    std::unique_ptr<FaceDetectorBase> m_faceDetector;
+	// Input of the signal plugin for the replay, written in the signal stage
+	ColorTraceWriter m_traceWriter;
+
+    std::shared_ptr<FaceDetectorBase> m_faceDetector;
+	// Face detector in the separate thread: the last finished detection is corrected by the tracker
+	std::unique_ptr<AsyncFaceDetector> m_asyncDetector;
+	std::deque<std::pair<int, cv::Rect>> m_trackHistory;
+	static const size_t MaxTrackHistory = 100;
     SkinDetector m_skinDetector;
+	RoiGrid m_roiGrid;
 
 #if USE_LK_TRACKER
 	LKTracker m_faceTracker;
 	FaceLandmarksDetector m_landmarksDetector;
 #else
 	cv::Ptr<cv::Tracker> m_faceTracker;
+	// Part of the frame the tracker works on: the whole frame or the padded face in the crop_only mode
+	cv::Rect m_trackRegion;
 #endif
+	DetectionScheduler m_detectScheduler;
 	FaceCrop m_faceCrop;
 
 	SignalPlugin m_signalProcessorColor;
@@ -71,4 +152,51 @@ private:
 	void DrawResult(cv::Mat frame, const cv::Rect& faceRect, const cv::Rect& resultFaceRect, const std::vector<cv::Point2f>& landmarks);
 
 	bool TrackFace(cv::Mat rgbFrame);
+#if !USE_LK_TRACKER
+	void InitFaceTracker(cv::Mat rgbFrame);
+#endif
+	void DetectTrackSync(cv::Mat rgbFrame, cv::Rect& face);
+	void DetectTrackAsync(cv::Mat rgbFrame, int frameInd, cv::Rect& face);
+	void AcceptDetection(cv::Rect& face, bool trackAttempted, bool tracked, cv::Mat rgbFrame);
+
+	// Processing stages. Every stage uses only its own members so they can work in parallel on the different frames
+	void DetectTrackStage(FrameResult& frameData);
+	void RoiStage(FrameResult& frameData);
+	void SignalStage(FrameResult& frameData);
+	void MotionAmplification(FrameResult& frameData, const cv::Rect& faceRect);
+	// Face crop or the whole frame for the motion amplification, the buffer is reused on every frame
+	cv::UMat m_maInput;
+	// Output frames of the motion amplification: m_imgProc of the FrameResult. Shared with the caller by GetFramePool
+	FramePool m_framePool;
+
+	// Multi face mode: every person has own tracker, skin detector and signal plugin
+	std::vector<std::unique_ptr<FaceSubject>> m_subjects;
+	std::vector<SubjectInfo> m_subjectsInfo;
+	std::vector<cv::Rect> m_detectedFaces;
+	std::vector<uchar> m_subjectsTracked;
+	std::vector<cv::Rect> m_subjectsPrevRects;
+	int m_nextSubjectId = 0;
+	static const int MaxMissedFrames = 10;
+
+	void SubjectsStage(FrameResult& frameData);
+	void MatchSubjects(cv::Mat rgbFrame);
+
+	bool m_pipelineMode = false;
+	// The state of the last popped result is returned by Get* functions: from StartPipeline until the next Process call
+	bool m_pipelineResults = false;
+	cv::Rect m_resultFaceRect;
+	std::vector<cv::Point2f> m_resultLandmarks;
+	int m_resultFrameInd = 0;
+	int CurrentFrameInd() const;
+	// Guards the signal plugin: it is used from the signal stage and from the Draw*/Get* functions
+	std::mutex m_signalMutex;
+
+	typedef BoundedQueue<FrameResult> FramesQueue;
+	std::unique_ptr<FramesQueue> m_detectQueue;
+	std::unique_ptr<FramesQueue> m_roiQueue;
+	std::unique_ptr<FramesQueue> m_signalQueue;
+	std::unique_ptr<FramesQueue> m_resultsQueue;
+	std::vector<std::thread> m_pipelineThreads;
+
+	void StageThread(FramesQueue* inQueue, FramesQueue* outQueue, void (MainProcess::*stage)(FrameResult&));
 };
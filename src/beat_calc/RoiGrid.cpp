@@ -0,0 +1,201 @@
+#include "RoiGrid.h"
+
+///
+/// \brief RoiGrid::Init
+/// \param gridSize
+/// \param fps
+///
+void RoiGrid::Init(int gridSize, double fps)
+{
+	m_gridSize = std::max(1, gridSize);
+	m_cells.resize(m_gridSize * m_gridSize);
+	m_weights.resize(m_cells.size());
+
+	// Heart rate band is [0.7, 4] Hz, the powers are averaged on 2 seconds
+	auto LowPassAlpha = [fps](double cutoff)
+	{
+		return 1. - exp(-2. * CV_PI * cutoff / std::max(1., fps));
+	};
+	m_dcAlpha = LowPassAlpha(0.7);
+	m_bandAlpha = LowPassAlpha(4.0);
+	m_powerAlpha = 1. - exp(-1. / (2. * std::max(1., fps)));
+
+	Reset();
+}
+
+///
+/// \brief RoiGrid::Reset
+///
+void RoiGrid::Reset()
+{
+	for (auto& cell : m_cells)
+	{
+		cell = Cell();
+	}
+	std::fill(m_weights.begin(), m_weights.end(), 0.);
+	std::fill(m_faceDc, m_faceDc + 3, 0.);
+	m_faceDcInitialized = false;
+}
+
+///
+/// \brief RoiGrid::Weights
+/// \return
+///
+const std::vector<double>& RoiGrid::Weights() const
+{
+	return m_weights;
+}
+
+///
+/// \brief RoiGrid::Process
+/// \param image
+/// \param mask
+/// \param colorVal
+/// \return
+///
+bool RoiGrid::Process(cv::Mat image, cv::Mat mask, cv::Scalar& colorVal)
+{
+	CV_Assert(image.type() == CV_8UC3 && (mask.empty() || (mask.type() == CV_8UC1 && mask.size() == image.size())));
+
+	for (auto& cell : m_cells)
+	{
+		std::fill(cell.m_sum, cell.m_sum + 3, 0);
+		cell.m_count = 0;
+	}
+	m_colCells.resize(image.cols);
+	for (int x = 0; x < image.cols; ++x)
+	{
+		m_colCells[x] = (x * m_gridSize) / image.cols;
+	}
+
+	for (int y = 0; y < image.rows; ++y)
+	{
+		Cell* rowCells = &m_cells[((y * m_gridSize) / image.rows) * m_gridSize];
+		const uchar* imgPtr = image.ptr(y);
+		const uchar* maskPtr = mask.empty() ? nullptr : mask.ptr(y);
+		for (int x = 0; x < image.cols; ++x, imgPtr += 3)
+		{
+			if (!maskPtr || maskPtr[x])
+			{
+				Cell& cell = rowCells[m_colCells[x]];
+				cell.m_sum[0] += imgPtr[0];
+				cell.m_sum[1] += imgPtr[1];
+				cell.m_sum[2] += imgPtr[2];
+				++cell.m_count;
+			}
+		}
+	}
+
+	// The cells with a few skin pixels are not used on this frame
+	const uint64 minCount = std::max<uint64>(1, static_cast<uint64>(image.total() / (10 * m_cells.size())));
+	// Power of the relative colour changes on the level of the 8 bit quantization of the cell mean
+	const double powerEps = 1e-8;
+	// Maximum band to noise ratio of the cell
+	const double maxCellWeight = 10.;
+
+	uint64 totalSum[3] = { 0, 0, 0 };
+	uint64 totalCount = 0;
+	double fused[3] = { 0, 0, 0 };
+	double weightsSum = 0;
+	int usedCells = 0;
+	for (size_t i = 0; i < m_cells.size(); ++i)
+	{
+		Cell& cell = m_cells[i];
+		for (int c = 0; c < 3; ++c)
+		{
+			totalSum[c] += cell.m_sum[c];
+		}
+		totalCount += cell.m_count;
+
+		m_weights[i] = 0;
+		if (cell.m_count < minCount)
+		{
+			continue;
+		}
+		double mean[3] = { 0, 0, 0 };
+		for (int c = 0; c < 3; ++c)
+		{
+			mean[c] = static_cast<double>(cell.m_sum[c]) / cell.m_count;
+		}
+		UpdateCell(cell, mean);
+		if (cell.m_dc[0] <= 0 || cell.m_dc[1] <= 0 || cell.m_dc[2] <= 0)
+		{
+			continue;
+		}
+
+		// Both powers are regularised: the cell without the changes (flat or saturated) has the weight 1,
+		// and the ratio is bounded so one cell with the almost zero noise doesn't take all the weight
+		double weight = std::min(maxCellWeight, (cell.m_bandPower + powerEps) / (cell.m_noisePower + powerEps));
+		m_weights[i] = weight;
+		weightsSum += weight;
+		for (int c = 0; c < 3; ++c)
+		{
+			// Relative colour changes are fused: the weights and the cells of different brightness don't move the signal level
+			fused[c] += weight * mean[c] / cell.m_dc[c];
+		}
+		++usedCells;
+	}
+
+	if (!totalCount)
+	{
+		return false;
+	}
+
+	// The relative changes are scaled back by the low pass colour of the whole face: it doesn't depend on the cells used on this frame,
+	// so the level doesn't jump when a cell is added or dropped by the minimum pixels count
+	for (int c = 0; c < 3; ++c)
+	{
+		const double mean = static_cast<double>(totalSum[c]) / totalCount;
+		m_faceDc[c] = m_faceDcInitialized ? (m_faceDc[c] + m_dcAlpha * (mean - m_faceDc[c])) : mean;
+	}
+	m_faceDcInitialized = true;
+
+	if (usedCells && weightsSum > 0)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			colorVal[c] = m_faceDc[c] * (fused[c] / weightsSum);
+		}
+		for (auto& weight : m_weights)
+		{
+			weight /= weightsSum;
+		}
+	}
+	else
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			colorVal[c] = static_cast<double>(totalSum[c]) / totalCount;
+		}
+	}
+	return true;
+}
+
+///
+/// \brief RoiGrid::UpdateCell
+/// \param cell
+/// \param mean
+///
+void RoiGrid::UpdateCell(Cell& cell, const double* mean)
+{
+	if (!cell.m_initialized)
+	{
+		std::copy(mean, mean + 3, cell.m_dc);
+		cell.m_initialized = true;
+		return;
+	}
+	for (int c = 0; c < 3; ++c)
+	{
+		cell.m_dc[c] += m_dcAlpha * (mean[c] - cell.m_dc[c]);
+	}
+	if (cell.m_dc[1] <= 0)
+	{
+		return;
+	}
+	// Green channel has the most of the pulse signal
+	double g = mean[1] / cell.m_dc[1] - 1.;
+	cell.m_band += m_bandAlpha * (g - cell.m_band);
+	double noise = g - cell.m_band;
+	cell.m_bandPower += m_powerAlpha * (cell.m_band * cell.m_band - cell.m_bandPower);
+	cell.m_noisePower += m_powerAlpha * (noise * noise - cell.m_noisePower);
+}
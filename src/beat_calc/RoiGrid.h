@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+///
+/// \brief The RoiGrid class
+/// The face rect is divided to gridSize x gridSize cells, the mean colours of the cells are fused
+/// with the weights by the signal to noise ratio of every cell:
+/// power in the heart rate band to the power of the higher frequencies, both from the recursive filters
+///
+class RoiGrid
+{
+public:
+	///
+	/// \brief Init
+	/// \param gridSize - cells in the row and in the column
+	/// \param fps
+	///
+	void Init(int gridSize, double fps);
+	///
+	/// \brief Reset
+	/// Forget the signals of the cells, for example, when the face was lost
+	///
+	void Reset();
+
+	///
+	/// \brief Process
+	/// One pass over the image: sums of the colours and number of the pixels under the mask for every cell
+	/// \param image - CV_8UC3
+	/// \param mask - CV_8UC1 with the same size or empty for the all pixels
+	/// \param colorVal - fused colour value
+	/// \return false if there are no pixels under the mask
+	///
+	bool Process(cv::Mat image, cv::Mat mask, cv::Scalar& colorVal);
+
+	///
+	/// \brief Weights
+	/// Fusion weights of the cells on the last frame, row by row. The sum of the weights is 1, the not used cells have 0
+	///
+	const std::vector<double>& Weights() const;
+
+private:
+	struct Cell
+	{
+		uint64 m_sum[3] = { 0, 0, 0 };
+		uint64 m_count = 0;
+
+		bool m_initialized = false;
+		double m_dc[3] = { 0, 0, 0 };  // Low pass colour value
+		double m_band = 0;             // Normalized green value after the low pass on the maximum heart rate frequency
+		double m_bandPower = 0;
+		double m_noisePower = 0;
+	};
+	std::vector<Cell> m_cells;
+	std::vector<double> m_weights;
+	std::vector<int> m_colCells;
+
+	int m_gridSize = 1;
+
+	// Low pass colour of the whole face: the level of the fused signal
+	double m_faceDc[3] = { 0, 0, 0 };
+	bool m_faceDcInitialized = false;
+
+	// Coefficients of the one pole low pass filters
+	double m_dcAlpha = 0;
+	double m_bandAlpha = 0;
+	double m_powerAlpha = 0;
+
+	void UpdateCell(Cell& cell, const double* mean);
+};
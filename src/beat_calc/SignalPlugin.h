@@ -59,6 +59,13 @@ public:
 				std::cout << "Some functions was not exported from " << dllName << std::endl;
 				std::cerr << ex.what() << std::endl;
 			}
+
+			// Optional export: older plugins receive the measures one by one
+			m_AddMeasures.clear();
+			if (m_lib.has("AddMeasures"))
+			{
+				m_AddMeasures = m_lib.get<AddMeasures_t>("AddMeasures");
+			}
 		}
 		return m_lib.is_loaded();
 	}
@@ -72,6 +79,7 @@ public:
 		}
 		if (m_lib.is_loaded())
 		{
+			m_AddMeasures.clear();
 			m_lib.unload();
 		}
 	}
@@ -100,6 +108,27 @@ public:
 		//std::cout << "m_AddMeasure: m_handle = " << m_handle << ", val3d = " << val3d[0] << std::endl;
 	}
 
+	///
+	/// \brief AddMeasures
+	/// \param count
+	/// \param captureTimes - count time stamps
+	/// \param rgb - count * 3 color values
+	///
+	void AddMeasures(int count, const __int64* captureTimes, const double* rgb)
+	{
+		if (m_AddMeasures)
+		{
+			m_AddMeasures(m_handle, count, captureTimes, rgb);
+		}
+		else
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				m_AddMeasure(m_handle, captureTimes[i], rgb + 3 * i);
+			}
+		}
+	}
+
 	void MeasureFrequency(double freq, int frameInd, bool showMixture)
 	{
 		m_MeasureFrequency(m_handle, freq, frameInd, showMixture);
@@ -143,6 +172,7 @@ private:
 	typedef int(__cdecl DestroyPlugin_t)(intptr_t);
 	typedef int(__cdecl Reset_t)(intptr_t);
 	typedef int(__cdecl AddMeasure_t)(intptr_t, __int64, const double*);
+	typedef int(__cdecl AddMeasures_t)(intptr_t, int, const __int64*, const double*);
 	typedef int(__cdecl MeasureFrequency_t)(intptr_t, double, int, bool);
 	typedef int(__cdecl GetFrequency_t)(intptr_t, FrequencyResults*);
 	typedef int(__cdecl RemainingMeasurements_t)(intptr_t, int*);
@@ -152,6 +182,7 @@ private:
 	boost::function<DestroyPlugin_t> m_DestroyPlugin;
 	boost::function<Reset_t> m_Reset;
 	boost::function<AddMeasure_t> m_AddMeasure;
+	boost::function<AddMeasures_t> m_AddMeasures;
 	boost::function<MeasureFrequency_t> m_MeasureFrequency;
 	boost::function<GetFrequency_t> m_GetFrequency;
 	boost::function<RemainingMeasurements_t> m_RemainingMeasurements;
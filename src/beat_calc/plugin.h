@@ -62,6 +62,11 @@ struct InputParams
 	float gauss_proc_weight_thresh;
 	bool retExpFreq;
 	float fps;
+	int interpolation;                // Интерполяция при переносе сигнала на равномерную сетку: 0 - линейная, 1 - кубическая, 2 - Ланцош
+	bool bandSpectrum;                // Вычислять спектр только в диапазоне частот пульса скользящим ДПФ вместо полного БПФ (только signal_vpg)
+	int fftSize;                      // Размер спектра: сигнал дополняется нулями до этого размера, 0 - равен framesCount
+	int peakInterpolation;            // Уточнение частоты пика между отсчётами спектра: 0 - нет, 1 - параболическое, 2 - Якобсена
+	int measureHop;                   // Вычислять частоту каждые measureHop отсчётов, между ними возвращается последний результат
 };
 
 ///
@@ -121,6 +126,15 @@ extern "C"
     ///
     PLUGIN_EXPORTS int PLUGIN_FTYPE AddMeasure(intptr_t handle, __int64 captureTime, const double* val3d);
 
+    ///
+    /// \brief Добавление пачки измерений за один вызов, например, при обработке записанного сигнала
+    /// \param count - количество измерений
+    /// \param captureTimes - pointer to the count time stamps
+    /// \param rgb - pointer to the count * 3 color values
+	/// \return 0 if succed and another if fails
+    ///
+    PLUGIN_EXPORTS int PLUGIN_FTYPE AddMeasures(intptr_t handle, int count, const __int64* captureTimes, const double* rgb);
+
     ///
     /// \brief GetFrequency - получение значения частоты и других дополнительных величин, которые можно вывести пользователю
 	/// \param freqResults - значение частоты и других величин
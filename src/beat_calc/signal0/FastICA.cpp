@@ -2,121 +2,139 @@
 
 const double FastICA::alpha = 1.0;
 // --------------------------------------------------------
-// 
+// W = (W * W')^(-1/2) * W
 // --------------------------------------------------------
-Eigen::MatrixXd FastICA::sym_decorrelation(Eigen::MatrixXd mixing_matrix)
+Eigen::Matrix3d FastICA::sym_decorrelation(const Eigen::Matrix3d& mixing_matrix)
 {
-    Eigen::MatrixXd K = mixing_matrix * mixing_matrix.transpose();
-    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig;
+    Eigen::Matrix3d K = mixing_matrix * mixing_matrix.transpose();
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig;
 	eig.compute(K);
-    return ((eig.eigenvectors() * eig.eigenvalues().cwiseSqrt().asDiagonal().inverse()) * eig.eigenvectors().transpose()) * mixing_matrix;
+    return ((eig.eigenvectors() * eig.eigenvalues().cwiseSqrt().cwiseInverse().asDiagonal()) * eig.eigenvectors().transpose()) * mixing_matrix;
 }
 // --------------------------------------------------------
-// 
+//
 // --------------------------------------------------------
-
-double FastICA::gx(double x)
+FastICA::FastICA()
 {
-	return tanh(x*alpha);
+	max_iter = 200;
+	tol = 1e-10;
 }
 // --------------------------------------------------------
-// 
+//
 // --------------------------------------------------------
-double FastICA::g_x(double x)
+FastICA::~FastICA()
 {
-	return alpha * (1.0 - gx(x)*gx(x));
+
 }
 // --------------------------------------------------------
-// 
+//
 // --------------------------------------------------------
-FastICA::FastICA() 
+void FastICA::Reset()
 {
-	max_iter = 200;
-	tol = 1e-10;
+    m_hasUnmixing = false;
 }
 // --------------------------------------------------------
-// 
+//
 // --------------------------------------------------------
-FastICA::~FastICA()
+int FastICA::Iterations() const
 {
-
+    return m_iterations;
 }
 // --------------------------------------------------------
-// 
+//
 // --------------------------------------------------------
-void FastICA::apply(cv::Mat& src, cv::Mat& dst, cv::Mat& W)
+void FastICA::apply(const cv::Mat& src, cv::Mat& dst, cv::Mat& W)
 {
-    Eigen::MatrixXd X = Eigen::MatrixXd(src.rows, src.cols);
+    CV_Assert(src.type() == CV_64FC1 && src.rows == 3 && src.isContinuous());
 
-	cv2eigen(src, X);
-	apply(X);
-	eigen2cv(X,dst);
-	eigen2cv(m_mixing_matrix,W);
-}
-// --------------------------------------------------------
-// 
-// --------------------------------------------------------
-Eigen::MatrixXd FastICA::apply(Eigen::MatrixXd& X)
-{
-	int n = X.rows();
-	int p = X.cols();
-	int m = n;
+    const int p = src.cols;
+    Eigen::Map<const Signal3d> X(src.ptr<double>(0), 3, p);
 
-	// Whiten
-    Eigen::VectorXd mean = (X.rowwise().sum() / (double)p);
-    Eigen::MatrixXd SPX = X.colwise() - mean;
+	// Whiten: eigen decomposition of the 3x3 covariance instead of SVD of the 3xN data
+    const Eigen::Vector3d mean = X.rowwise().sum() / static_cast<double>(p);
+    Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+    for (int j = 0; j < p; ++j)
+    {
+        const Eigen::Vector3d x = X.col(j) - mean;
+        cov.noalias() += x * x.transpose();
+    }
+    cov /= static_cast<double>(p);
 
-    Eigen::JacobiSVD<Eigen::MatrixXd> svd;
-	svd.compute(SPX, Eigen::ComputeThinU);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig;
+    eig.compute(cov);
+    const Eigen::Vector3d sigma = eig.eigenvalues().cwiseMax(std::numeric_limits<double>::epsilon()).cwiseSqrt();
+	// see Hyvarinen (6.33) p.140: K * (X - mean) has the identity covariance
+    const Eigen::Matrix3d K = sigma.cwiseInverse().asDiagonal() * eig.eigenvectors().transpose();
 
-    Eigen::MatrixXd u = svd.matrixU();
-    Eigen::MatrixXd d = svd.singularValues();
+    m_white.resize(3, p);
 
-	// see Hyvarinen (6.33) p.140
-    Eigen::MatrixXd K = u.transpose();
-	for (int r = 0; r < K.rows(); r++)
-	{
-		K.row(r) /= d(r);
-	}
-	// see Hyvarinen (13.6) p.267 Here WX is white and data
-	// in X has been projected onto a subspace by PCA
-    Eigen::MatrixXd WX = K * SPX;
-	WX *= sqrt((double)p);
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    // FastICATest builds this file with EIGEN_RUNTIME_NO_MALLOC: the rest of apply must not allocate.
+    // The flag of Eigen is global for all threads, so the plugin itself is built without it
+    Eigen::internal::set_is_malloc_allowed(false);
+#endif
 
-	cv::RNG rng;
-	// Initial mixing matrix estimate
-	if (m_mixing_matrix.rows() != m || m_mixing_matrix.cols() != m)
-	{
-        m_mixing_matrix = Eigen::MatrixXd(m,m);
-		for (int i = 0; i < m; i++)
-		{
-			for (int j = 0; j < m; j++)
-			{
-				m_mixing_matrix(i,j) = rng.gaussian(1);
-			}
-		}
-	}
+    // Column by column: the product with the whole (X - mean) expression evaluates it to a temporary
+    for (int j = 0; j < p; ++j)
+    {
+        m_white.col(j).noalias() = K * (X.col(j) - mean);
+    }
 
-	m_mixing_matrix = sym_decorrelation(m_mixing_matrix);
+	// Initial mixing matrix estimate
+    Eigen::Matrix3d mixing_matrix;
+    if (m_hasUnmixing)
+    {
+        // Unmixing of the previous window in the current whitened space: W_prev * K^(-1)
+        mixing_matrix = m_unmixing * (eig.eigenvectors() * sigma.asDiagonal());
+    }
+    else
+    {
+        cv::RNG rng;
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                mixing_matrix(i, j) = rng.gaussian(1);
+            }
+        }
+    }
+	mixing_matrix = sym_decorrelation(mixing_matrix);
 
-	int iter = 0;
-	double lim = tol+1;
-	while (lim > tol && iter < max_iter)
+	m_iterations = 0;
+	double lim = tol + 1;
+	while (lim > tol && m_iterations < max_iter)
 	{
-        Eigen::MatrixXd wtx = m_mixing_matrix * WX;
-        Eigen::MatrixXd gwtx  = wtx.unaryExpr(std::cref(gx));
-        Eigen::MatrixXd g_wtx = wtx.unaryExpr(std::cref(g_x));
-        Eigen::MatrixXd W1 = (gwtx * WX.transpose()) / (double)p - (g_wtx.rowwise().sum()/(double)p).asDiagonal() * m_mixing_matrix;
+        // One pass over the signal: g(wx) = tanh(alpha * wx) and g'(wx) = alpha * (1 - g^2) together
+        Eigen::Matrix3d gwx = Eigen::Matrix3d::Zero();
+        Eigen::Vector3d g_wx = Eigen::Vector3d::Zero();
+        for (int j = 0; j < p; ++j)
+        {
+            const Eigen::Vector3d z = m_white.col(j);
+            const Eigen::Vector3d g = (mixing_matrix * z * alpha).array().tanh();
+            gwx.noalias() += g * z.transpose();
+            g_wx += (1.0 - g.array().square()).matrix();
+        }
+        Eigen::Matrix3d W1 = gwx / static_cast<double>(p) - (g_wx * (alpha / static_cast<double>(p))).asDiagonal() * mixing_matrix;
 		W1 = sym_decorrelation(W1);
-		lim = ((W1 * m_mixing_matrix.transpose()).diagonal().cwiseAbs().array() - 1.0).abs().maxCoeff();
-		m_mixing_matrix = W1;
-		iter++;
+		lim = ((W1 * mixing_matrix.transpose()).diagonal().cwiseAbs().array() - 1.0).abs().maxCoeff();
+		mixing_matrix = W1;
+		m_iterations++;
 	}
 
-	// Unmix
-	m_mixing_matrix = (m_mixing_matrix*K);
-	X = m_mixing_matrix * X;
-	// set m_mixing_matrix
-	m_mixing_matrix = m_mixing_matrix.inverse();
-	return X;
+    m_unmixing = mixing_matrix * K;
+    m_hasUnmixing = true;
+
+	// Unmix: the same scale as the previous SVD version, K / sqrt(p)
+    const Eigen::Matrix3d unmixing = m_unmixing / sqrt(static_cast<double>(p));
+    dst.create(3, p, CV_64FC1);
+    Eigen::Map<Signal3d> D(dst.ptr<double>(0), 3, p);
+    D.noalias() = unmixing * X;
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    Eigen::internal::set_is_malloc_allowed(true);
+#endif
+
+	// Mixing matrix
+    Eigen::Matrix3d mixing = unmixing.inverse();
+	eigen2cv(mixing, W);
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <cmath>
-#define EIGEN_RUNTIME_NO_MALLOC // Define this symbol to enable runtime tests for allocations
+#include <limits>
 #include <Eigen/Dense>
 
 #include <vector>
@@ -9,25 +9,48 @@
 #include "opencv2/core/eigen.hpp"
 
 // --------------------------------------------------------
-// 
+// FastICA for the 3 channels (RGB) signal.
+// The object keeps the unmixing matrix of the previous window and starts from it:
+// the next window differs by one sample so only a few iterations are needed
 // --------------------------------------------------------
 class FastICA
 {
 public:
 	FastICA();
 	~FastICA();
-    void apply(cv::Mat& src, cv::Mat& dst, cv::Mat& W);
+    ///
+    /// \param src - 3xN CV_64FC1
+    /// \param dst - 3xN CV_64FC1 independent components
+    /// \param W - 3x3 mixing matrix
+    ///
+    void apply(const cv::Mat& src, cv::Mat& dst, cv::Mat& W);
+
+    ///
+    /// \brief Reset
+    /// Forget the previous unmixing matrix, the next apply starts from the random one
+    ///
+    void Reset();
+
+    ///
+    /// \brief Iterations
+    /// \return Iterations count of the last apply
+    ///
+    int Iterations() const;
 
 private:
-    Eigen::MatrixXd m_mixing_matrix;
+    typedef Eigen::Matrix<double, 3, Eigen::Dynamic, Eigen::RowMajor> Signal3d;
+
+    // Unmixing matrix in the source data space (whitening included), used as the initial estimate
+    Eigen::Matrix3d m_unmixing;
+    bool m_hasUnmixing = false;
+    // Whitened signal
+    Signal3d m_white;
+
 	int max_iter;
 	double tol;
+    int m_iterations = 0;
 
     static const double alpha; // alpha must be in range [1.0 - 2.0]
 
-    static Eigen::MatrixXd sym_decorrelation(Eigen::MatrixXd mixing_matrix);
-    static double gx(double x);
-    static double g_x(double x);
-    Eigen::MatrixXd apply(Eigen::MatrixXd& features);
-}; 
-
+    static Eigen::Matrix3d sym_decorrelation(const Eigen::Matrix3d& mixing_matrix);
+};
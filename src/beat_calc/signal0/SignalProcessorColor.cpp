@@ -1,7 +1,8 @@
 #include "SignalProcessorColor.h"
-#include "FastICA.h"
 #include "pca.h"
 
+#include <complex>
+
 ///
 /// \brief SignalProcessorColor::SignalProcessorColor
 /// \param framesCount
@@ -11,7 +12,9 @@ SignalProcessorColor::SignalProcessorColor(size_t framesCount,
                                            float gauss_def_var, float gauss_min_var, float gauss_max_var,
                                            float gauss_eps, float gauss_update_alpha,
                                            float gauss_proc_alpha, float gauss_proc_weight_thresh,
-	                                       bool retExpFreq)
+	                                       bool retExpFreq, MeasureSettings::Interpolations interpolation,
+	                                       int fftSize, MeasureSettings::PeakInterpolations peakInterpolation,
+	                                       int measureHop)
     :
       m_minSignalSize(framesCount),
       m_filterType(filterType),
@@ -21,8 +24,13 @@ SignalProcessorColor::SignalProcessorColor(size_t framesCount,
       m_maxFreq(0),
       m_currFreq(0),
 	  m_expFreq(0),
-	  m_retExpFreq(retExpFreq)
+	  m_retExpFreq(retExpFreq),
+	  m_interpolation(interpolation),
+	  m_fftSize(fftSize),
+	  m_peakInterpolation(peakInterpolation),
+	  m_measureHop(std::max(1, measureHop))
 {
+	m_queue.Init(m_minSignalSize);
 }
 
 ///
@@ -30,12 +38,14 @@ SignalProcessorColor::SignalProcessorColor(size_t framesCount,
 ///
 void SignalProcessorColor::Reset()
 {
-    m_queue.clear();
+    m_queue.Clear();
     m_FF.Reset();
     m_minFreq = 0;
     m_maxFreq = 0;
     m_currFreq = 0;
 	m_expFreq = 0;
+	m_ica.Reset();
+	m_samplesAfterMeasure = -1;
 }
 
 ///
@@ -45,15 +55,37 @@ void SignalProcessorColor::Reset()
 ///
 void SignalProcessorColor::AddMeasure(int64 captureTime, const ClVal_t& val)
 {
-    m_queue.push_back(Measure<ClVal_t>(captureTime, val));
-    if (m_queue.size() > /*2 **/m_minSignalSize)
-    {
-        m_queue.pop_front();
-    }
+    m_queue.PushBack(captureTime, val);
+	if (m_samplesAfterMeasure >= 0)
+	{
+		++m_samplesAfterMeasure;
+	}
 
 	if (m_colorsLog.is_open())
 	{
-		m_colorsLog << val[0] << "; " << val[1] << "; " << val[2] << std::endl;
+		m_colorsLog << val[0] << "; " << val[1] << "; " << val[2] << "\n";
+	}
+}
+
+///
+/// \brief SignalProcessorColor::AddMeasures
+/// \param count
+/// \param captureTimes
+/// \param rgb
+///
+void SignalProcessorColor::AddMeasures(int count, const int64* captureTimes, const double* rgb)
+{
+	for (int i = 0; i < count; ++i, rgb += 3)
+	{
+		m_queue.PushBack(captureTimes[i], ClVal_t(rgb[0], rgb[1], rgb[2]));
+		if (m_colorsLog.is_open())
+		{
+			m_colorsLog << rgb[0] << "; " << rgb[1] << "; " << rgb[2] << "\n";
+		}
+	}
+	if (m_samplesAfterMeasure >= 0)
+	{
+		m_samplesAfterMeasure += count;
 	}
 }
 
@@ -63,7 +95,7 @@ void SignalProcessorColor::AddMeasure(int64 captureTime, const ClVal_t& val)
 ///
 int SignalProcessorColor::RemainingMeasurements() const
 {
-	return (m_minSignalSize > m_queue.size()) ? int(m_minSignalSize - m_queue.size()) : 0;
+	return (m_minSignalSize > m_queue.Size()) ? int(m_minSignalSize - m_queue.Size()) : 0;
 }
 
 ///
@@ -87,64 +119,131 @@ void SignalProcessorColor::GetFrequency(FrequencyResults* freqResults) const
 }
 
 ///
-/// \brief SignalProcessorColor::FindValueForTime
+/// \brief SignalProcessorColor::ValueForTime
+/// \param data
+/// \param ind
 /// \param _t
 /// \return
 ///
-SignalProcessorColor::ClVal_t SignalProcessorColor::FindValueForTime(const std::deque<Measure<ClVal_t>>& queue, int64 _t)
+SignalProcessorColor::ClVal_t SignalProcessorColor::ValueForTime(const ColorRingBuffer::Span& data, size_t ind, double _t) const
 {
-    auto it_prev = queue.begin();
-    for (auto it = queue.begin(); it < queue.end(); ++it)
-    {
-        if (it->t >= _t)
-        {
-            if (it_prev->t == it->t)
-            {
-                return it->val;
-            }
-            else
-            {
-                double dt = double(it->t - it_prev->t);
-                ClVal_t d_val = ClVal_t(it->val - it_prev->val);
-                double t_rel = _t - it_prev->t;
-                ClVal_t val_rel = d_val * (t_rel / dt);
-                return val_rel + it_prev->val;
-            }
-        }
-        it_prev = it;
-    }
-    assert(0);
-    return ClVal_t();
+	const int64* times = data.m_time;
+	auto Value = [&data](size_t k)
+	{
+		return ClVal_t(data.m_values[0][k], data.m_values[1][k], data.m_values[2][k]);
+	};
+
+	const size_t n = data.m_size;
+	if (ind + 1 >= n)
+	{
+		return Value(ind);
+	}
+	const int64 t0 = times[ind];
+	const ClVal_t v0 = Value(ind);
+	const ClVal_t v1 = Value(ind + 1);
+	const double h = static_cast<double>(times[ind + 1] - t0);
+	if (h <= 0)
+	{
+		return v1;
+	}
+	const double s = std::max(0., std::min(1., (_t - t0) / h));
+
+	switch (m_interpolation)
+	{
+	case MeasureSettings::InterpCubic:
+	{
+		// Cubic Hermite spline, tangents are finite differences on the non uniform time grid
+		auto Tangent = [&](size_t k) -> ClVal_t
+		{
+			size_t k0 = (k > 0) ? (k - 1) : k;
+			size_t k1 = (k + 1 < n) ? (k + 1) : k;
+			double tk = static_cast<double>(times[k1] - times[k0]);
+			return (tk > 0) ? ClVal_t((Value(k1) - Value(k0)) * (1. / tk)) : ClVal_t();
+		};
+		const double s2 = s * s;
+		const double s3 = s2 * s;
+		return v0 * (2. * s3 - 3. * s2 + 1.) + Tangent(ind) * (h * (s3 - 2. * s2 + s)) +
+				v1 * (3. * s2 - 2. * s3) + Tangent(ind + 1) * (h * (s3 - s2));
+	}
+
+	case MeasureSettings::InterpLanczos:
+	{
+		// Lanczos window a = 3 in the measures indices: the time between ind and ind + 1 is mapped linearly,
+		// the weights are normalized because the kernel is cut near the ends of the queue
+		const int a = 3;
+		auto Kernel = [a](double x) -> double
+		{
+			x = std::abs(x);
+			if (x < 1e-9)
+			{
+				return 1.;
+			}
+			if (x >= a)
+			{
+				return 0.;
+			}
+			const double px = CV_PI * x;
+			return a * sin(px) * sin(px / a) / (px * px);
+		};
+		const size_t from = (ind + 1 > static_cast<size_t>(a)) ? (ind + 1 - a) : 0;
+		const size_t to = std::min(n - 1, ind + a);
+		ClVal_t sum;
+		double weights = 0;
+		for (size_t k = from; k <= to; ++k)
+		{
+			double w = Kernel(static_cast<double>(ind) + s - static_cast<double>(k));
+			sum += Value(k) * w;
+			weights += w;
+		}
+		if (weights > 1e-9)
+		{
+			return sum * (1. / weights);
+		}
+		return v0 + (v1 - v0) * s;
+	}
+
+	case MeasureSettings::InterpLinear:
+	default:
+		return v0 + (v1 - v0) * s;
+	}
 }
 
 ///
 /// \brief SignalProcessorColor::UniformTimedPoints
-/// \param NumSamples
 /// \param dst
 /// \param dt
 /// \param Freq
 ///
-void SignalProcessorColor::UniformTimedPoints(const std::deque<Measure<ClVal_t>>& queue, cv::Mat& dst, double& dt, double Freq)
+void SignalProcessorColor::UniformTimedPoints(cv::Mat& dst, double& dt, double Freq)
 {
-	int NumSamples = static_cast<int>(queue.size());
-    if (dst.empty() ||
-            dst.size() != cv::Size(3, NumSamples))
-    {
-        dst = cv::Mat(3, NumSamples, CV_64FC1);
-    }
-
-    dt = (queue.back().t - queue.front().t) / (double)NumSamples;
-    int64 T = queue.front().t;
-    for (int i = 0; i < NumSamples; ++i)
-    {
-        T += dt;
+	// The measures are one contiguous span of the ring buffer, they are read in place
+	const ColorRingBuffer::Span data = m_queue.Data();
+	const int NumSamples = static_cast<int>(data.m_size);
+	dst.create(3, NumSamples, CV_64FC1);
+	double* dst0 = dst.ptr<double>(0);
+	double* dst1 = dst.ptr<double>(1);
+	double* dst2 = dst.ptr<double>(2);
+
+	const double t0 = static_cast<double>(data.m_time[0]);
+	const double t1 = static_cast<double>(data.m_time[data.m_size - 1]);
+	dt = (t1 - t0) / NumSamples;
+
+	// data.m_time[ind] < T <= data.m_time[ind + 1]
+	size_t ind = 0;
+	for (int i = 0; i < NumSamples; ++i)
+	{
+		const double T = std::min(t1, t0 + (i + 1) * dt);
+		while (ind + 2 < data.m_size && data.m_time[ind + 1] < T)
+		{
+			++ind;
+		}
 
-        ClVal_t val = FindValueForTime(queue, T);
-        dst.at<double>(0, i) = val[0];
-        dst.at<double>(1, i) = val[1];
-        dst.at<double>(2, i) = val[2];
-    }
-    dt /= Freq;
+		ClVal_t val = ValueForTime(data, ind, T);
+		dst0[i] = val[0];
+		dst1[i] = val[1];
+		dst2[i] = val[2];
+	}
+	dt /= Freq;
 }
 
 ///
@@ -162,8 +261,7 @@ void SignalProcessorColor::FilterRGBSignal(cv::Mat& src, cv::Mat& dst)
         cv::Mat W;
         cv::Mat d;
         int N = 0; // Номер независимой компоненты, используемой для измерения частоты
-        FastICA fica;
-        fica.apply(src, d, W); // Производим разделение компонентов
+        m_ica.apply(src, d, W); // Производим разделение компонентов
         d.row(N) *= (W.at<double>(N, N) > 0) ? 1 : -1; // Инверсия при отрицательном коэффициенте
         dst = d.row(N).clone();
     }
@@ -200,8 +298,7 @@ void SignalProcessorColor::FilterRGBSignal(cv::Mat& src, std::vector<cv::Mat>& d
     {
         cv::Mat W;
         cv::Mat d;
-        FastICA fica;
-        fica.apply(src, d, W); // Производим разделение компонентов
+        m_ica.apply(src, d, W); // Производим разделение компонентов
 
         dst.resize(d.rows);
         for (int i = 0; i < d.rows; ++i)
@@ -233,54 +330,63 @@ void SignalProcessorColor::FilterRGBSignal(cv::Mat& src, std::vector<cv::Mat>& d
 }
 
 ///
-void normalization(cv::InputArray _a, cv::OutputArray _b)
-{
-	_a.getMat().copyTo(_b);
-	cv::Mat b = _b.getMat();
-	cv::Scalar mean;
-	cv::Scalar stdDev;
-	cv::meanStdDev(b, mean, stdDev);
-	b = (b - mean[0]) / stdDev[0];
-}
-
+/// \brief normalization
+/// (b - mean) / stdDev in place
 ///
-void meanFilter(cv::InputArray _a, cv::OutputArray _b, size_t n, cv::Size s)
+void normalization(double* b, int n)
 {
-	_a.getMat().copyTo(_b);
-	cv::Mat b = _b.getMat();
-	for (size_t i = 0; i < n; i++)
+	double mean = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		mean += b[i];
+	}
+	mean /= n;
+	double var = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		var += (b[i] - mean) * (b[i] - mean);
+	}
+	const double invStdDev = (var > 0) ? (1. / sqrt(var / n)) : 0.;
+	for (int i = 0; i < n; ++i)
 	{
-		cv::blur(b, b, s);
+		b[i] = (b[i] - mean) * invStdDev;
 	}
 }
 
 ///
-template<typename T>
-void detrend(cv::Mat _z, cv::Mat& _r, int lambda = 10) 
+/// \brief meanFilter
+/// Repeated box filter with the running sum, the same as cv::blur with BORDER_REFLECT_101 for the one row signal
+/// \param b - signal, filtered in place
+/// \param tmp - buffer with n elements
+///
+void meanFilter(double* b, double* tmp, int n, size_t iterations, int radius)
 {
-	CV_DbgAssert((_z.type() == CV_32F || _z.type() == CV_64F)
-		&& _z.total() == std::max(_z.size().width, _z.size().height));
-
-	cv::Mat z = _z.total() == (size_t)_z.size().height ? _z : _z.t();
-	if (z.total() < 3)
+	if (n < 2)
 	{
-		z.copyTo(_r);
+		return;
 	}
-	else
+	auto Reflect101 = [n](int i) -> int
+	{
+		while (i < 0 || i >= n)
+		{
+			i = (i < 0) ? -i : (2 * n - 2 - i);
+		}
+		return i;
+	};
+	const double norm = 1. / (2 * radius + 1);
+	for (size_t it = 0; it < iterations; ++it)
 	{
-		int t = static_cast<int>(z.total());
-		cv::Mat i = cv::Mat::eye(t, t, z.type());
-		cv::Mat d = cv::Mat(cv::Matx<T, 1, 3>(1, -2, 1));
-		cv::Mat d2Aux = cv::Mat::ones(t - 2, 1, z.type()) * d;
-		cv::Mat d2 = cv::Mat::zeros(t - 2, t, z.type());
-		for (int k = 0; k < 3; k++)
+		std::copy(b, b + n, tmp);
+		double sum = 0;
+		for (int i = -radius; i <= radius; ++i)
 		{
-			d2Aux.col(k).copyTo(d2.diag(k));
+			sum += tmp[Reflect101(i)];
+		}
+		for (int i = 0; i < n; ++i)
+		{
+			b[i] = sum * norm;
+			sum += tmp[Reflect101(i + radius + 1)] - tmp[Reflect101(i - radius)];
 		}
-		cv::Mat r = (i - (i + lambda * lambda * d2.t() * d2).inv()) * z;
-		//r.copyTo(_r);
-		
-		_r = r.reshape(1, 1);
 	}
 }
 
@@ -305,37 +411,28 @@ void SignalProcessorColor::MakeFourier(
         double& maxFreq)
 {
     // Преобразование Фурье
-	cv::Mat res;
+	// All buffers are members: no allocations while the window size is the same
+	cv::Mat& res = m_fourierSignal;
 	if (m_signalNormalization)
 	{
 		// process raw signal
-		detrend<double>(signal, res, cvRound(1000 / (2 * deltaTime)));
-		normalization(res, res);
-		meanFilter(res, res, 3, cv::Size(5, 5));
+		m_detrend.Apply(signal, res, cvRound(1000 / (2 * deltaTime)));
+		m_fourierTmp.resize(res.cols);
+		normalization(res.ptr<double>(0), res.cols);
+		meanFilter(res.ptr<double>(0), m_fourierTmp.data(), res.cols, 3, 2);
 	}
 	else
 	{
-		res = signal.clone();
+		signal.copyTo(res);
 	}
 
-    cv::Mat z = cv::Mat::zeros(1, signal.cols, CV_64FC1);
-    std::vector<cv::Mat> ch;
-    ch.push_back(res);
-    ch.push_back(z);
-    cv::merge(ch, res);
-
-    cv::Mat res_freq;
-    cv::dft(res, res_freq);
-    cv::split(res_freq, ch);
-    // Мощность спектра
-    cv::magnitude(ch[0], ch[1], spectrum);
-    // Квадрат мощности спектра
-    cv::pow(spectrum, 2.0, spectrum);
+	// Zero padding gives the finer grid of the spectrum without the longer window
+	const int fftSize = std::max(signal.cols, m_fftSize);
 
 #if 1
 #if 1
-	const double total = signal.cols;
-	auto Ind2Freq = [&](int ind) -> double
+	const double total = fftSize;
+	auto Ind2Freq = [&](double ind) -> double
 	{
 		return (ind * 1000. * deltaTime * 60.0) / (2. * total);
 	};
@@ -361,7 +458,7 @@ void SignalProcessorColor::MakeFourier(
 	// Где T - полное время, за которое выполнено преобразование.
 	// "Примерно" из - за того, что в первой половине массива частоты положительные, во второй - отрицательные
 
-	const double total = signal.cols;
+	const double total = fftSize;
 	auto Ind2Freq = [&](int ind) -> double
 	{
 		return (2.0 * M_PI * ind * 60.0) / (total);
@@ -383,14 +480,33 @@ void SignalProcessorColor::MakeFourier(
 		std::swap(fromToFreq.x, fromToFreq.y);
 	}
 
-	double minS = 0;
-	double maxS = 0;
-	cv::Point minI;
-	cv::Point maxI;
-	cv::minMaxLoc(spectrum, &minS, &maxS, &minI, &maxI);
-	std::cout << "ff1 = " << fromToFreq.x << ", ff2 = " << fromToFreq.y << std::endl;
-	std::cout << "spectrum: " << spectrum.size() << ", min = " << minI << " - " << minS << ", max = " << maxI << " - " << maxS << std::endl;
-	//std::cout << signal << std::endl;
+	// Real input: packed CCS output Re0, Re1, Im1, ..., power spectrum directly from it
+	if (fftSize > res.cols)
+	{
+		m_fourierPadded.create(1, fftSize, CV_64FC1);
+		res.copyTo(m_fourierPadded(cv::Rect(0, 0, res.cols, 1)));
+		m_fourierPadded(cv::Rect(res.cols, 0, fftSize - res.cols, 1)).setTo(0);
+		cv::dft(m_fourierPadded, m_fourierCCS);
+	}
+	else
+	{
+		cv::dft(res, m_fourierCCS);
+	}
+	const double* ccs = m_fourierCCS.ptr<double>(0);
+	const int n = fftSize;
+	spectrum.create(1, n, CV_64FC1);
+	double* power = spectrum.ptr<double>(0);
+	power[0] = ccs[0] * ccs[0];
+	for (int k = 1; k < (n + 1) / 2; ++k)
+	{
+		power[k] = ccs[2 * k - 1] * ccs[2 * k - 1] + ccs[2 * k] * ccs[2 * k];
+		power[n - k] = power[k];
+	}
+	if (n % 2 == 0)
+	{
+		power[n / 2] = ccs[n - 1] * ccs[n - 1];
+	}
+
 	spectrum(cv::Rect(0, 0, fromToFreq.x, 1)).setTo(0);
 	spectrum(cv::Rect(fromToFreq.y, 0, spectrum.cols - fromToFreq.y, 1)).setTo(0);
 
@@ -400,7 +516,8 @@ void SignalProcessorColor::MakeFourier(
     // Найдем 3 пика на частотном разложении
     const size_t INDS_COUNT = 3;
     int inds[INDS_COUNT] = { -1 };
-    std::deque<double> maxVals;
+    double maxVals[INDS_COUNT] = { 0 };
+    size_t valsCount = 0;
 
     auto IsLocalMax = [](double v1, double v2, double v3) -> bool
     {
@@ -416,7 +533,7 @@ void SignalProcessorColor::MakeFourier(
         int ind = x;
         if (IsLocalMax(v1, v2, v3))
         {
-            for (size_t i = 0; i < maxVals.size(); ++i)
+            for (size_t i = 0; i < valsCount; ++i)
             {
                 if (maxVals[i] < v2)
                 {
@@ -424,32 +541,79 @@ void SignalProcessorColor::MakeFourier(
                     std::swap(inds[i], ind);
                 }
             }
-            if (maxVals.size() < INDS_COUNT)
+            if (valsCount < INDS_COUNT)
             {
-                maxVals.push_back(v2);
-                inds[maxVals.size() - 1] = ind;
+                maxVals[valsCount] = v2;
+                inds[valsCount] = ind;
+                ++valsCount;
             }
         }
         v1 = v2;
         v2 = v3;
     }
 
+    // Уточним положение пиков между отсчётами спектра
+	auto SubBinIndex = [&](int ind) -> double
+	{
+		if (m_peakInterpolation == MeasureSettings::PeakNone || ind < 1 || ind + 1 >= spectrum.cols)
+		{
+			return ind;
+		}
+		double delta = 0;
+		if (m_peakInterpolation == MeasureSettings::PeakJacobsen)
+		{
+			// Jacobsen estimator on the complex bins from the CCS packed spectrum
+			const double* ccs = m_fourierCCS.ptr<double>(0);
+			auto Bin = [&](int k) -> std::complex<double>
+			{
+				const bool conj = k > fftSize / 2;
+				k = conj ? (fftSize - k) : k;
+				if (k == 0)
+				{
+					return std::complex<double>(ccs[0], 0);
+				}
+				if (2 * k == fftSize)
+				{
+					return std::complex<double>(ccs[fftSize - 1], 0);
+				}
+				return std::complex<double>(ccs[2 * k - 1], conj ? -ccs[2 * k] : ccs[2 * k]);
+			};
+			const std::complex<double> denom = 2. * Bin(ind) - Bin(ind - 1) - Bin(ind + 1);
+			if (std::abs(denom) > std::numeric_limits<double>::epsilon())
+			{
+				delta = std::real((Bin(ind - 1) - Bin(ind + 1)) / denom);
+			}
+		}
+		else
+		{
+			// Parabola through the magnitudes of the peak and its neighbours
+			const double a = sqrt(spectrum.at<double>(0, ind - 1));
+			const double b = sqrt(spectrum.at<double>(0, ind));
+			const double c = sqrt(spectrum.at<double>(0, ind + 1));
+			const double denom = a - 2. * b + c;
+			if (denom < 0)
+			{
+				delta = 0.5 * (a - c) / denom;
+			}
+		}
+		return ind + std::max(-0.5, std::min(0.5, delta));
+	};
+
     // И вычислим частоту
 	maxFreq = Ind2Freq(1);
 	minFreq = Ind2Freq(spectrum.cols - 1);
 
 	currFreq = -1;
-    for (size_t i = 0; i < maxVals.size(); ++i)
+    for (size_t i = 0; i < valsCount; ++i)
     {
         if (inds[i] > 0)
         {
-            double freq = Ind2Freq(inds[i]);
+            double freq = Ind2Freq(SubBinIndex(inds[i]));
             m_FF.AddMeasure(freq);
 
             if (currFreq < 0)
             {
                 currFreq = freq;
-                std::cout << "spectrum.size = " << spectrum.cols << ", maxInd = " << inds[i] << ", deltaTime = " << deltaTime << ", freq [" << minFreq << ", " << maxFreq << "] = " << currFreq << " - " << m_FF.CurrValue() << std::endl;
             }
         }
     }
@@ -474,16 +638,6 @@ void SignalProcessorColor::MakeFourier(
 
 		freqValues.push_back(Ind2Freq(x));
 	}
-
-	std::vector<double> robustFreqs;
-	m_FF.RobustValues(robustFreqs);
-
-	std::cout << "Robust frequences: ";
-	for (auto v : robustFreqs)
-	{
-		std::cout << v << " ";
-	}
-	std::cout << std::endl;
 }
 
 ///
@@ -495,45 +649,31 @@ int SignalProcessorColor::MeasureFrequency(double freq,
 	int frameInd,
 	bool showMixture)
 {
-    if (m_queue.size() < m_minSignalSize)
+    if (m_queue.Size() < m_minSignalSize)
     {
-        return int(m_minSignalSize - m_queue.size());
+        return int(m_minSignalSize - m_queue.Size());
     }
-
-	std::deque<Measure<ClVal_t>> workQueue;
-#if 0
-	auto IsPowerOfTwo = [](size_t v) -> bool
-	{
-		return (v && !(v & (v - 1)));
-	};
-	if (m_queue.size() >= m_minSignalSize && IsPowerOfTwo(m_queue.size()))
+	// Between the hops only the new samples were added, the last result is actual
+	if (m_samplesAfterMeasure >= 0 && m_samplesAfterMeasure < m_measureHop)
 	{
-		workQueue.assign(m_queue.begin(), m_queue.end());
+		return 0;
 	}
-	else
-	{
-		workQueue.assign(m_queue.begin() + (m_queue.size() - m_minSignalSize), m_queue.end());
-	}
-	std::cout << "queue size = " << m_queue.size() << ", workQueue size = " << workQueue.size() << std::endl;
-#else
-	workQueue.assign(m_queue.begin(), m_queue.end());
-#endif
+	m_samplesAfterMeasure = 0;
 
     // Чтобы частота сэмплирования не плавала, разместим сигнал с временными метками на равномерной сетке
-	cv::Mat src;
+	cv::Mat& src = m_uniformSignal;
 	m_lastDeltatime = 0;
-    UniformTimedPoints(workQueue, src, m_lastDeltatime, freq);
+    UniformTimedPoints(src, m_lastDeltatime, freq);
 
     switch (m_filterType)
     {
 	case MeasureSettings::FilterPCA:
 	case MeasureSettings::FilterGreen:
 	{
-		cv::Mat dst;
+		m_correctedSignal.resize(1);
+		cv::Mat& dst = m_correctedSignal[0];
 		FilterRGBSignal(src, dst);
 
-		m_correctedSignal.resize(1);
-		m_correctedSignal[0] = dst;
 		m_spectrumPower.resize(1);
 		m_freqValues.resize(1);
 		m_fromToFreq.resize(1);
@@ -2,6 +2,9 @@
 
 #include "../../common/common.h"
 #include "stat.h"
+#include "detrend.h"
+#include "ring_buffer.h"
+#include "FastICA.h"
 
 ///
 /// \brief The SignalProcessorColor class
@@ -24,7 +27,9 @@ public:
                          float gauss_def_var, float gauss_min_var, float gauss_max_var,
                          float gauss_eps, float gauss_update_alpha,
                          float gauss_proc_alpha, float gauss_proc_weight_thresh,
-		                 bool retExpFreq);
+		                 bool retExpFreq, MeasureSettings::Interpolations interpolation,
+		                 int fftSize, MeasureSettings::PeakInterpolations peakInterpolation,
+		                 int measureHop);
 
     ///
     /// \brief Reset
@@ -38,6 +43,14 @@ public:
     ///
     void AddMeasure(int64 captureTime, const ClVal_t& val);
 
+	///
+	/// \brief Добавление пачки измерений
+	/// \param count
+	/// \param captureTimes
+	/// \param rgb - count * 3 color values
+	///
+	void AddMeasures(int count, const int64* captureTimes, const double* rgb);
+
     ///
     /// \brief GetInstantaneousFreq
     /// \param freqResults
@@ -111,10 +124,45 @@ private:
 	///
 	bool m_retExpFreq = false;
 
+	///
+	/// \brief m_interpolation
+	/// Interpolation for the resampling on the uniform time grid
+	///
+	MeasureSettings::Interpolations m_interpolation = MeasureSettings::InterpLinear;
+
+	///
+	/// \brief m_fftSize
+	/// The signal is padded with zeros up to this size before the spectrum calculation
+	///
+	int m_fftSize = 0;
+
+	///
+	/// \brief m_peakInterpolation
+	/// Sub bin estimation of the peaks frequency
+	///
+	MeasureSettings::PeakInterpolations m_peakInterpolation = MeasureSettings::PeakNone;
+
+	///
+	/// \brief m_measureHop
+	/// Frequency is measured every m_measureHop samples
+	///
+	int m_measureHop = 1;
+	///
+	/// \brief m_samplesAfterMeasure
+	/// Samples added after the last measurement, -1 if there was no measurement
+	///
+	int m_samplesAfterMeasure = -1;
+
     ///
     /// \brief m_queue
+    /// Last m_minSignalSize measures
     ///
-    std::deque<Measure<ClVal_t>> m_queue;
+    ColorRingBuffer m_queue;
+
+	///
+	/// \brief Signal on the uniform time grid
+	///
+	cv::Mat m_uniformSignal;
 
 	///
 	/// \brief Signal after correction and filtration
@@ -133,6 +181,26 @@ private:
 	///
 	double m_lastDeltatime = 0.0;
 
+	///
+	/// \brief m_detrend
+	/// Detrending with the cached factorization
+	///
+	HPDetrend m_detrend;
+
+	///
+	/// \brief m_ica
+	/// Starts from the unmixing matrix of the previous window
+	///
+	FastICA m_ica;
+
+	///
+	/// \brief Buffers of MakeFourier
+	///
+	cv::Mat m_fourierSignal;
+	cv::Mat m_fourierPadded;
+	cv::Mat m_fourierCCS;
+	std::vector<double> m_fourierTmp;
+
 	///
 	/// \brief m_colorsLog
 	///
@@ -140,19 +208,21 @@ private:
 
     ///
     /// \brief Преобразуем очередь измерений с метками времени в измерения на равномерной временной сетке
-    /// \param NumSamples
+    /// Times of the grid are increasing so it is a single pass over m_queue without search and copying
     /// \param dst
     /// \param dt
     /// \param Freq
     ///
-    void UniformTimedPoints(const std::deque<Measure<ClVal_t>>& queue, cv::Mat& dst, double& dt, double Freq);
+    void UniformTimedPoints(cv::Mat& dst, double& dt, double Freq);
 
     ///
-    /// \brief Вычисляем значение для произвольного момента времени, при помощи кусочно-линейной интерполяции по имеющимся в очереди элементам
+    /// \brief Вычисляем значение для произвольного момента времени _t, лежащего между data[ind] и data[ind + 1]
+    /// \param data - measures of m_queue
+    /// \param ind
     /// \param _t
     /// \return
     ///
-    ClVal_t FindValueForTime(const std::deque<Measure<ClVal_t>>& queue, int64 _t);
+    ClVal_t ValueForTime(const ColorRingBuffer::Span& data, size_t ind, double _t) const;
 
     ///
     /// \brief Выделяем первый сигнал (первый собственный вектор)
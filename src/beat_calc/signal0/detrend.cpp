@@ -0,0 +1,118 @@
+#include "detrend.h"
+
+///
+/// \brief HPDetrend::Factorize
+/// \param t
+/// \param lambda
+///
+void HPDetrend::Factorize(int t, int lambda)
+{
+	m_size = t;
+	m_lambda = lambda;
+
+	m_d.assign(t, 1.);
+	m_l1.assign(t, 0.);
+	m_l2.assign(t, 0.);
+	m_x.resize(t);
+
+	// Bands of A = I + mu * D2' * D2: diagonal in m_d, first and second superdiagonals in m_l1 and m_l2
+	const double mu = static_cast<double>(lambda) * lambda;
+	const double c[3] = { 1., -2., 1. };
+	for (int k = 0; k < t - 2; ++k)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			m_d[k + a] += mu * c[a] * c[a];
+		}
+		m_l1[k] += mu * c[0] * c[1];
+		m_l1[k + 1] += mu * c[1] * c[2];
+		m_l2[k] += mu * c[0] * c[2];
+	}
+
+	// A = L * D * L'
+	for (int j = 0; j < t; ++j)
+	{
+		double d = m_d[j];
+		if (j > 0)
+		{
+			d -= m_l1[j - 1] * m_l1[j - 1] * m_d[j - 1];
+		}
+		if (j > 1)
+		{
+			d -= m_l2[j - 2] * m_l2[j - 2] * m_d[j - 2];
+		}
+		m_d[j] = d;
+
+		if (j > 0)
+		{
+			m_l1[j] -= m_l2[j - 1] * m_l1[j - 1] * m_d[j - 1];
+		}
+		m_l1[j] /= d;
+		m_l2[j] /= d;
+	}
+}
+
+///
+/// \brief HPDetrend::Apply
+/// \param z
+/// \param r
+/// \param t
+/// \param lambda
+///
+void HPDetrend::Apply(const double* z, double* r, int t, int lambda)
+{
+	if (t < 3)
+	{
+		std::copy(z, z + t, r);
+		return;
+	}
+	if (t != m_size || lambda != m_lambda)
+	{
+		Factorize(t, lambda);
+	}
+
+	double* x = &m_x[0];
+
+	// L * y = z
+	x[0] = z[0];
+	x[1] = z[1] - m_l1[0] * x[0];
+	for (int j = 2; j < t; ++j)
+	{
+		x[j] = z[j] - m_l1[j - 1] * x[j - 1] - m_l2[j - 2] * x[j - 2];
+	}
+	// D * w = y
+	for (int j = 0; j < t; ++j)
+	{
+		x[j] /= m_d[j];
+	}
+	// L' * x = w
+	x[t - 2] -= m_l1[t - 2] * x[t - 1];
+	for (int j = t - 3; j >= 0; --j)
+	{
+		x[j] -= m_l1[j] * x[j + 1] + m_l2[j] * x[j + 2];
+	}
+
+	for (int j = 0; j < t; ++j)
+	{
+		r[j] = z[j] - x[j];
+	}
+}
+
+///
+/// \brief HPDetrend::Apply
+/// \param z
+/// \param r
+/// \param lambda
+///
+void HPDetrend::Apply(cv::Mat z, cv::Mat& r, int lambda)
+{
+	CV_Assert(z.type() == CV_64FC1 && z.total() == static_cast<size_t>(std::max(z.rows, z.cols)));
+
+	const int t = static_cast<int>(z.total());
+	if (!z.isContinuous())
+	{
+		z = z.clone();
+	}
+	r.create(1, t, CV_64FC1);
+	Apply(z.ptr<double>(), r.ptr<double>(), t, lambda);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief The HPDetrend class
+/// Hodrick-Prescott detrending: r = z - x, where (I + lambda^2 * D2' * D2) * x = z.
+/// The matrix is symmetric pentadiagonal so it is factorized with banded Cholesky (LDL', without square roots)
+/// in O(n). Factorization is cached for the last (signal size, lambda)
+///
+class HPDetrend
+{
+public:
+	///
+	/// \brief Apply
+	/// \param z - input signal, 1xN or Nx1 CV_64FC1
+	/// \param r - detrended signal 1xN CV_64FC1
+	/// \param lambda - smoothing parameter
+	///
+	void Apply(cv::Mat z, cv::Mat& r, int lambda);
+
+	///
+	/// \brief Apply
+	/// r and z can be the same array
+	///
+	void Apply(const double* z, double* r, int t, int lambda);
+
+private:
+	int m_size = 0;
+	int m_lambda = -1;
+
+	// Factorization: L - unit lower triangular with 2 subdiagonals, D - diagonal
+	std::vector<double> m_d;
+	std::vector<double> m_l1;
+	std::vector<double> m_l2;
+	// Solution of the system
+	std::vector<double> m_x;
+
+	void Factorize(int t, int lambda);
+};
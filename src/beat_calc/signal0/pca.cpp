@@ -91,43 +91,159 @@ bool MakePCA(
 	return true;
 }
 
+///
+/// \brief LargestEigenVector
+/// Closed form eigen decomposition of the symmetric 3x3 matrix (trigonometric solution of the characteristic equation)
+/// \param cov - a00, a01, a02, a11, a12, a22
+/// \param vec - unit eigen vector of the largest eigen value
+///
+static void LargestEigenVector(const double cov[6], cv::Vec3d& vec)
+{
+	const double a00 = cov[0], a01 = cov[1], a02 = cov[2], a11 = cov[3], a12 = cov[4], a22 = cov[5];
+
+	const double p1 = a01 * a01 + a02 * a02 + a12 * a12;
+	const double q = (a00 + a11 + a22) / 3.;
+	const double p2 = (a00 - q) * (a00 - q) + (a11 - q) * (a11 - q) + (a22 - q) * (a22 - q) + 2. * p1;
+	if (p2 <= std::numeric_limits<double>::epsilon() * q * q)
+	{
+		// A = q * I: every vector is the eigen vector
+		vec = cv::Vec3d(1., 0., 0.);
+		return;
+	}
+	const double p = sqrt(p2 / 6.);
+	const double b00 = (a00 - q) / p, b11 = (a11 - q) / p, b22 = (a22 - q) / p;
+	const double b01 = a01 / p, b02 = a02 / p, b12 = a12 / p;
+	const double r = 0.5 * (b00 * (b11 * b22 - b12 * b12) - b01 * (b01 * b22 - b12 * b02) + b02 * (b01 * b12 - b11 * b02));
+	const double phi = acos(std::max(-1., std::min(1., r))) / 3.;
+	const double lambda = q + 2. * p * cos(phi);
+
+	// Rows of A - lambda * I are orthogonal to the eigen vector: take the most robust cross product
+	const cv::Vec3d r0(a00 - lambda, a01, a02);
+	const cv::Vec3d r1(a01, a11 - lambda, a12);
+	const cv::Vec3d r2(a02, a12, a22 - lambda);
+	const cv::Vec3d c[3] = { r0.cross(r1), r0.cross(r2), r1.cross(r2) };
+	int best = 0;
+	double bestNorm = c[0].dot(c[0]);
+	for (int i = 1; i < 3; ++i)
+	{
+		double norm = c[i].dot(c[i]);
+		if (norm > bestNorm)
+		{
+			bestNorm = norm;
+			best = i;
+		}
+	}
+	if (bestNorm > std::numeric_limits<double>::epsilon() * p2 * p2)
+	{
+		vec = c[best] * (1. / sqrt(bestNorm));
+	}
+	else
+	{
+		// Largest eigen value is double: A - lambda * I has rank 1, any vector orthogonal to its non zero row
+		const cv::Vec3d rows[3] = { r0, r1, r2 };
+		int rowInd = 0;
+		for (int i = 1; i < 3; ++i)
+		{
+			if (rows[i].dot(rows[i]) > rows[rowInd].dot(rows[rowInd]))
+			{
+				rowInd = i;
+			}
+		}
+		const cv::Vec3d& row = rows[rowInd];
+		int axis = 0;
+		for (int i = 1; i < 3; ++i)
+		{
+			if (std::abs(row[i]) < std::abs(row[axis]))
+			{
+				axis = i;
+			}
+		}
+		cv::Vec3d e(0., 0., 0.);
+		e[axis] = 1.;
+		vec = cv::normalize(row.cross(e));
+	}
+
+	// Sign of the eigen vector is arbitrary: the largest coordinate is positive
+	int maxInd = 0;
+	for (int i = 1; i < 3; ++i)
+	{
+		if (std::abs(vec[i]) > std::abs(vec[maxInd]))
+		{
+			maxInd = i;
+		}
+	}
+	if (vec[maxInd] < 0)
+	{
+		vec = -vec;
+	}
+}
+
 ///
 /// \brief MakePCA
-/// \param src
-/// \param dst
+/// Projection of the RGB signal on the first principal component: one pass for the covariance,
+/// closed form 3x3 eigen solve and one pass for the projection without temporary matrices
+/// \param src - 3xN CV_64FC1
+/// \param dst - 1xN CV_64FC1
 /// \return
 ///
 bool MakePCA(const cv::Mat& src, cv::Mat& dst)
 {
-    const int vectorsCount = src.cols;
+	CV_Assert(src.type() == CV_64FC1 && src.rows == 3);
 
-    const int componentsCount = 3;
-    cv::PCA pca(src, cv::Mat(), cv::PCA::DATA_AS_COL, componentsCount);
+	const int vectorsCount = src.cols;
+	const double* r = src.ptr<double>(0);
+	const double* g = src.ptr<double>(1);
+	const double* b = src.ptr<double>(2);
 
-    double minV = std::numeric_limits<double>::max();
-    double maxV = -std::numeric_limits<double>::max();
+	double mean[3] = { 0, 0, 0 };
+	for (int idx = 0; idx < vectorsCount; ++idx)
+	{
+		mean[0] += r[idx];
+		mean[1] += g[idx];
+		mean[2] += b[idx];
+	}
+	for (auto& m : mean)
+	{
+		m /= vectorsCount;
+	}
 
-    for (int idx = 0; idx < vectorsCount; ++idx)
-    {
-        cv::Vec3d feature(src.at<double>(0, idx), src.at<double>(1, idx), src.at<double>(2, idx));
-        cv::Mat projected = pca.project(feature);
-        double val = projected.at<double>(0, 0);
-        minV = std::min(minV, val);
+	// a00, a01, a02, a11, a12, a22
+	double cov[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int idx = 0; idx < vectorsCount; ++idx)
+	{
+		const double dr = r[idx] - mean[0];
+		const double dg = g[idx] - mean[1];
+		const double db = b[idx] - mean[2];
+		cov[0] += dr * dr;
+		cov[1] += dr * dg;
+		cov[2] += dr * db;
+		cov[3] += dg * dg;
+		cov[4] += dg * db;
+		cov[5] += db * db;
+	}
 
-        maxV = std::max(maxV, val);
-    }
+	cv::Vec3d vec;
+	LargestEigenVector(cov, vec);
+	const double offset = vec.dot(cv::Vec3d(mean[0], mean[1], mean[2]));
 
-    dst.create(1, vectorsCount, CV_64FC1);
+	dst.create(1, vectorsCount, CV_64FC1);
+	double* res = dst.ptr<double>(0);
 
-    for (int idx = 0; idx < vectorsCount; ++idx)
-    {
-        cv::Vec3d feature(src.at<double>(0, idx), src.at<double>(1, idx), src.at<double>(2, idx));
-        cv::Mat projected = pca.project(feature);
+	double minV = std::numeric_limits<double>::max();
+	double maxV = -std::numeric_limits<double>::max();
+	for (int idx = 0; idx < vectorsCount; ++idx)
+	{
+		const double val = vec[0] * r[idx] + vec[1] * g[idx] + vec[2] * b[idx] - offset;
+		res[idx] = val;
+		minV = std::min(minV, val);
+		maxV = std::max(maxV, val);
+	}
 
-        double value = projected.at<double>(0, 0);
-        value = 255.f * (value - minV) / (maxV - minV);
-        dst.at<double>(0, idx) = value;
-    }
+	const double scale = (maxV > minV) ? (255. / (maxV - minV)) : 0.;
+	for (int idx = 0; idx < vectorsCount; ++idx)
+	{
+		res[idx] = scale * (res[idx] - minV);
+	}
 
-    return true;
+	return true;
 }
@@ -16,7 +16,11 @@ intptr_t PLUGIN_FTYPE CreatePlugin(const InputParams* inputParams)
 		inputParams->gauss_update_alpha,
 		inputParams->gauss_proc_alpha,
 		inputParams->gauss_proc_weight_thresh,
-		inputParams->retExpFreq);
+		inputParams->retExpFreq,
+		(MeasureSettings::Interpolations)inputParams->interpolation,
+		inputParams->fftSize,
+		(MeasureSettings::PeakInterpolations)inputParams->peakInterpolation,
+		inputParams->measureHop);
     return reinterpret_cast<intptr_t>(signalProcess);
 }
 
@@ -76,6 +80,23 @@ int PLUGIN_FTYPE AddMeasure(intptr_t handle, __int64 captureTime, const double*
 	return 0;
 }
 
+///
+/// \brief AddMeasures
+/// \param count
+/// \param captureTimes
+/// \param rgb - pointer to the count * 3 color values
+///
+int PLUGIN_FTYPE AddMeasures(intptr_t handle, int count, const __int64* captureTimes, const double* rgb)
+{
+	SignalProcessorColor* signalProcess = reinterpret_cast<SignalProcessorColor*>(handle);
+	if (signalProcess == nullptr || count < 0 || (count > 0 && (captureTimes == nullptr || rgb == nullptr)))
+	{
+		return -1;
+	}
+	signalProcess->AddMeasures(count, captureTimes, rgb);
+	return 0;
+}
+
 ///
 /// \brief GetFrequency
 /// \param handle
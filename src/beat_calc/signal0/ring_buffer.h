@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief The ColorRingBuffer class
+/// Fixed capacity queue of the colour measures: time stamps and R, G, B are stored in the separate contiguous arrays.
+/// The new measure replaces the oldest one when the buffer is full, memory is allocated only in Init.
+/// Every measure is written twice, to pos and pos + capacity, so the measures from the oldest to the newest
+/// are always one contiguous span: readers index the arrays directly without the wrap around
+///
+class ColorRingBuffer
+{
+public:
+	///
+	/// \brief The Span struct
+	/// All measures of the buffer without copying, ordered from old to new measures
+	///
+	struct Span
+	{
+		const int64* m_time = nullptr;
+		const double* m_values[3] = { nullptr, nullptr, nullptr };
+		size_t m_size = 0;
+	};
+
+	///
+	/// \brief Init
+	/// \param capacity
+	///
+	void Init(size_t capacity)
+	{
+		m_capacity = std::max<size_t>(1, capacity);
+		m_time.resize(2 * m_capacity);
+		for (auto& values : m_values)
+		{
+			values.resize(2 * m_capacity);
+		}
+		Clear();
+	}
+
+	///
+	/// \brief Clear
+	///
+	void Clear()
+	{
+		m_head = 0;
+		m_size = 0;
+	}
+
+	///
+	/// \brief PushBack
+	/// \param t
+	/// \param val
+	///
+	void PushBack(int64 t, const cv::Vec3d& val)
+	{
+		size_t pos = m_head + m_size;
+		if (pos >= m_capacity)
+		{
+			pos -= m_capacity;
+		}
+		for (size_t mirror : { pos, pos + m_capacity })
+		{
+			m_time[mirror] = t;
+			m_values[0][mirror] = val[0];
+			m_values[1][mirror] = val[1];
+			m_values[2][mirror] = val[2];
+		}
+		if (m_size < m_capacity)
+		{
+			++m_size;
+		}
+		else
+		{
+			m_head = (m_head + 1 < m_capacity) ? (m_head + 1) : 0;
+		}
+	}
+
+	size_t Size() const
+	{
+		return m_size;
+	}
+	size_t Capacity() const
+	{
+		return m_capacity;
+	}
+	bool Empty() const
+	{
+		return m_size == 0;
+	}
+
+	///
+	/// \brief Data
+	/// \return All measures from the oldest to the newest, valid until the next PushBack
+	///
+	Span Data() const
+	{
+		Span span;
+		span.m_time = m_time.data() + m_head;
+		for (int i = 0; i < 3; ++i)
+		{
+			span.m_values[i] = m_values[i].data() + m_head;
+		}
+		span.m_size = m_size;
+		return span;
+	}
+
+private:
+	size_t m_capacity = 0;
+	size_t m_head = 0;  // Position of the oldest measure, always less than m_capacity
+	size_t m_size = 0;
+
+	std::vector<int64> m_time;         // 2 * m_capacity: the second half repeats the first one
+	std::vector<double> m_values[3];
+};
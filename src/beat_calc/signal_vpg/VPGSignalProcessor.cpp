@@ -1,16 +1,18 @@
 #include <cstring>
+#include <algorithm>
 #include "VPGSignalProcessor.h"
 
 ///
-VPGSignalProcessor::VPGSignalProcessor(size_t framesCount, float fps, bool doFilter)
+VPGSignalProcessor::VPGSignalProcessor(size_t framesCount, float fps, bool doFilter, bool slidingDFT, int measureHop)
 	:
-	m_minSignalSize(framesCount), m_fps(fps), m_doFilter(doFilter)
+	m_minSignalSize(framesCount), m_fps(fps), m_doFilter(doFilter), m_measureHop(static_cast<size_t>(std::max(1, measureHop)))
 {
 	double framePeriod = 1000. * framesCount / fps;
 	m_pulseproc = std::make_unique<vpg::PulseProcessor>(framePeriod, 400., 350., 1000.f / fps, vpg::PulseProcessor::HeartRate);
 	int totalcardiointervals = 25;
 	m_peakdetector = std::make_unique<vpg::PeakDetector>(m_pulseproc->getLength(), totalcardiointervals, 11, framePeriod);
 	m_pulseproc->setPeakDetector(m_peakdetector.get());
+	m_pulseproc->setSlidingDFT(slidingDFT);
 }
 
 ///
@@ -70,7 +72,12 @@ int VPGSignalProcessor::MeasureFrequency(
 
 	if (m_minSignalSize < m_valuesRecieved)
 	{
-		m_pulseproc->computeFrequency();
+		// Between the hops only the new values were added, the last result is actual
+		if (!m_lastMeasured || m_valuesRecieved - m_lastMeasured >= m_measureHop)
+		{
+			m_pulseproc->computeFrequency();
+			m_lastMeasured = m_valuesRecieved;
+		}
 		return 0;
 	}
 	else
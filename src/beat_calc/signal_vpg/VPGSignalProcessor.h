@@ -11,7 +11,7 @@ public:
 	typedef cv::Vec3d ClVal_t;
 
 	///
-	VPGSignalProcessor(size_t framesCount, float fps, bool doFilter);
+	VPGSignalProcessor(size_t framesCount, float fps, bool doFilter, bool slidingDFT, int measureHop);
 
 	///
 	~VPGSignalProcessor();
@@ -52,6 +52,10 @@ private:
 
 	bool m_doFilter = false;
 
+	// Frequency is measured every m_measureHop samples
+	size_t m_measureHop = 1;
+	size_t m_lastMeasured = 0;
+
 	// Instance of PulseProcessor (it analyzes counts of skin reflection and computes heart rate by means on FFT analysis)
 	std::unique_ptr<vpg::PulseProcessor> m_pulseproc;
 	
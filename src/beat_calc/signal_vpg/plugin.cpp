@@ -7,7 +7,7 @@
 ///
 intptr_t PLUGIN_FTYPE CreatePlugin(const InputParams* inputParams)
 {
-	VPGSignalProcessor* signalProcess = new VPGSignalProcessor(inputParams->framesCount, inputParams->fps, inputParams->retExpFreq);
+	VPGSignalProcessor* signalProcess = new VPGSignalProcessor(inputParams->framesCount, inputParams->fps, inputParams->retExpFreq, inputParams->bandSpectrum, inputParams->measureHop);
     return reinterpret_cast<intptr_t>(signalProcess);
 }
 
@@ -67,6 +67,26 @@ int PLUGIN_FTYPE AddMeasure(intptr_t handle, __int64 captureTime, const double*
 	return 0;
 }
 
+///
+/// \brief AddMeasures
+/// \param count
+/// \param captureTimes
+/// \param rgb - pointer to the count * 3 color values
+///
+int PLUGIN_FTYPE AddMeasures(intptr_t handle, int count, const __int64* captureTimes, const double* rgb)
+{
+	VPGSignalProcessor* signalProcess = reinterpret_cast<VPGSignalProcessor*>(handle);
+	if (signalProcess == nullptr || count < 0 || (count > 0 && (captureTimes == nullptr || rgb == nullptr)))
+	{
+		return -1;
+	}
+	for (int i = 0; i < count; ++i, rgb += 3)
+	{
+		signalProcess->AddMeasure(captureTimes[i], VPGSignalProcessor::ClVal_t(rgb[0], rgb[1], rgb[2]));
+	}
+	return 0;
+}
+
 ///
 /// \brief GetFrequency
 /// \param handle
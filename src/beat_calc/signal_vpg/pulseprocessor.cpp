@@ -75,6 +75,9 @@ PulseProcessor::~PulseProcessor()
 
 void PulseProcessor::update(double value, double time, bool filter)
 {
+    const double prevY = v_Y[curpos];
+    const double prevTime = v_time[curpos];
+
     if(filter) {
         v_raw[curpos] = value;
         if(std::abs(time - m_dTms) < m_dTms) {
@@ -115,23 +118,27 @@ void PulseProcessor::update(double value, double time, bool filter)
 	if(pt_peakdetector != 0)
         pt_peakdetector->update(v_Y[curpos], v_time[curpos]);
 
+    if(m_slidingDFT) {
+        // Only one count of the window was changed: X[k] += (y_new - y_old) * exp(-2 * pi * i * k * curpos / N)
+        const double delta = v_Y[curpos] - prevY;
+        for(int k = m_slidingBottom; k <= m_slidingTop; k++)
+            v_bins[k - m_slidingBottom] += delta * v_twiddles[(static_cast<long long>(k) * curpos) % m_length];
+        m_zeros += (std::abs(v_Y[curpos]) <= 0.01 ? 1 : 0) - (std::abs(prevY) <= 0.01 ? 1 : 0);
+        m_timeSum += v_time[curpos] - prevTime;
+
+        // Exact recalculation once per window length against accumulated rounding errors
+        if(++m_slidingCounts >= m_length)
+            __resyncSlidingDFT();
+    }
+
     curpos = (curpos + 1) % m_length;
 }
 
-double PulseProcessor::computeFrequency()
+void PulseProcessor::__fullSpectrum()
 {
-    unsigned int _zeros = 0;
     double *pt = v_datamat.ptr<double>(0);
-    for(int i = 0; i < m_length; i++) {
+    for(int i = 0; i < m_length; i++)
         pt[i] = v_Y[__loop(curpos - 1 - i)];
-        if(std::abs(pt[i]) <= 0.01) {
-            _zeros++;
-        }
-    }
-    if(_zeros > 0.5 * m_length) {
-        m_snr = -10.0;
-        return m_Frequency;
-    }
     //cv::blur(v_datamat,v_datamat,cv::Size(3,1));
     cv::dft(v_datamat, v_dftmat);
     const double *v_fft = v_dftmat.ptr<const double>(0);
@@ -146,16 +153,50 @@ double PulseProcessor::computeFrequency()
         for(int i = 1; i <= m_length/2; i++)
             v_FA[i] = v_fft[2*i-1]*v_fft[2*i-1] + v_fft[2*i]*v_fft[2*i];
     }
+}
 
+double PulseProcessor::computeFrequency()
+{
     // Count time
     double time = 0.0;
-    for (int i = 0; i < m_length; i++)
-        time += v_time[i];
+    if(m_slidingDFT) {
+        if(m_zeros > 0.5 * m_length) {
+            m_snr = -10.0;
+            return m_Frequency;
+        }
+        time = m_timeSum;
+    } else {
+        unsigned int _zeros = 0;
+        for(int i = 0; i < m_length; i++) {
+            if(std::abs(v_Y[i]) <= 0.01) {
+                _zeros++;
+            }
+        }
+        if(_zeros > 0.5 * m_length) {
+            m_snr = -10.0;
+            return m_Frequency;
+        }
+        __fullSpectrum();
+
+        for (int i = 0; i < m_length; i++)
+            time += v_time[i];
+    }
 
     int bottom = (int)(m_bottomFrequencyLimit * time / 1000.0);
     int top = (int)(m_topFrequencyLimit * time / 1000.0);
     if(top > (m_length/2))
         top = m_length/2;
+
+    if(m_slidingDFT) {
+        // The power spectrum doesn't depend on the circular shift and the reverse of the window
+        if(bottom >= m_slidingBottom && top <= m_slidingTop) {
+            for(int i = m_slidingBottom; i <= m_slidingTop; i++)
+                v_FA[i] = std::norm(v_bins[i - m_slidingBottom]);
+        } else {
+            __fullSpectrum();
+        }
+    }
+
     int i_maxpower = 0;
     double maxpower = 0.0;
     for (int i = bottom + 2 ; i <= top - 2; i++)
@@ -228,4 +269,44 @@ void PulseProcessor::setPeakDetector(PeakDetector *pointer)
     pt_peakdetector = pointer;
 }
 
+void PulseProcessor::setSlidingDFT(bool enabled)
+{
+    m_slidingDFT = enabled;
+    v_bins.clear();
+    v_twiddles.clear();
+    if(!m_slidingDFT)
+        return;
+
+    // Band bins with the margin for the jitter of the counts time
+    double time = m_length * m_dTms;
+    m_slidingBottom = std::max(0, static_cast<int>(0.5 * m_bottomFrequencyLimit * time / 1000.0));
+    m_slidingTop = std::min(m_length / 2, static_cast<int>(1.5 * m_topFrequencyLimit * time / 1000.0) + 1);
+
+    v_twiddles.resize(m_length);
+    for(int i = 0; i < m_length; i++)
+        v_twiddles[i] = std::polar(1.0, -2.0 * CV_PI * i / m_length);
+    v_bins.resize(m_slidingTop - m_slidingBottom + 1);
+    std::fill(v_FA.begin(), v_FA.end(), 0.0);
+
+    __resyncSlidingDFT();
+}
+
+void PulseProcessor::__resyncSlidingDFT()
+{
+    for(int k = m_slidingBottom; k <= m_slidingTop; k++) {
+        std::complex<double> bin(0.0, 0.0);
+        for(int n = 0; n < m_length; n++)
+            bin += v_Y[n] * v_twiddles[(static_cast<long long>(k) * n) % m_length];
+        v_bins[k - m_slidingBottom] = bin;
+    }
+    m_zeros = 0;
+    m_timeSum = 0.0;
+    for(int n = 0; n < m_length; n++) {
+        if(std::abs(v_Y[n]) <= 0.01)
+            m_zeros++;
+        m_timeSum += v_time[n];
+    }
+    m_slidingCounts = 0;
+}
+
 } // end of namespace vpg
@@ -36,6 +36,7 @@
 #define DLLSPEC
 #endif
 //-------------------------------------------------------
+#include <complex>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include "peakdetector.h"
@@ -124,12 +125,20 @@ public:
      * @param pointer - self explained
      */
     void setPeakDetector(PeakDetector *pointer);
+    /**
+     * @brief setSlidingDFT - update only the spectrum bins of the heart rate band on each count instead of the full DFT in computeFrequency
+     * @param enabled - self explained
+     * @note spectrum returned by getSpectr() is filled only inside the band in this mode
+     */
+    void setSlidingDFT(bool enabled);
 
 private:
 
     int __loop(int d) const;
     int __seek(int d) const;
     void __init(double Tov_ms, double Tcn_ms, double Tlpf_ms, double dT_ms, ProcessType type);
+    void __fullSpectrum();
+    void __resyncSlidingDFT();
 
     std::vector<double> v_raw;
 	std::vector<double> v_time;
@@ -150,6 +159,17 @@ private:
     cv::Mat v_dftmat;
 
     PeakDetector *pt_peakdetector = 0;
+
+    // Sliding DFT: bins from m_slidingBottom to m_slidingTop of the circular v_Y,
+    // they are updated by the difference between the new and the replaced count
+    bool m_slidingDFT = false;
+    int m_slidingBottom = 0;
+    int m_slidingTop = -1;
+    int m_slidingCounts = 0; // counts after the last exact recalculation
+    int m_zeros = 0;         // counts of v_Y near zero
+    double m_timeSum = 0.0;  // sum of v_time
+    std::vector<std::complex<double>> v_bins;
+    std::vector<std::complex<double>> v_twiddles;
 };
 
 inline int PulseProcessor::__loop(int d) const
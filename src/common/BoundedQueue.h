@@ -0,0 +1,93 @@
+#pragma once
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+
+///
+/// \brief The BoundedQueue class
+/// Thread safe FIFO queue with limited capacity: Push blocks while the queue is full, Pop blocks while it is empty
+///
+template<typename T>
+class BoundedQueue
+{
+public:
+	///
+	BoundedQueue(size_t capacity)
+		: m_capacity(std::max<size_t>(1, capacity))
+	{
+	}
+
+	///
+	/// \brief Push
+	/// \return false if the queue was closed
+	///
+	bool Push(T&& val)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condFull.wait(lock, [this]() { return m_closed || m_queue.size() < m_capacity; });
+		if (m_closed)
+		{
+			return false;
+		}
+		m_queue.push_back(std::move(val));
+		lock.unlock();
+		m_condEmpty.notify_one();
+		return true;
+	}
+
+	///
+	/// \brief Pop
+	/// \param val
+	/// \param wait - wait for the new element or return immediately
+	/// \return false if the queue is empty (and closed when wait == true)
+	///
+	bool Pop(T& val, bool wait = true)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (wait)
+		{
+			m_condEmpty.wait(lock, [this]() { return m_closed || !m_queue.empty(); });
+		}
+		if (m_queue.empty())
+		{
+			return false;
+		}
+		val = std::move(m_queue.front());
+		m_queue.pop_front();
+		lock.unlock();
+		m_condFull.notify_one();
+		return true;
+	}
+
+	///
+	/// \brief Close
+	/// Wake up all waiting threads. The remaining elements can be popped after closing
+	///
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+		}
+		m_condFull.notify_all();
+		m_condEmpty.notify_all();
+	}
+
+	///
+	size_t Size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size();
+	}
+
+private:
+	size_t m_capacity = 1;
+	bool m_closed = false;
+	std::deque<T> m_queue;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condFull;
+	std::condition_variable m_condEmpty;
+};
@@ -0,0 +1,169 @@
+#include "ColorTrace.h"
+
+#include <cstring>
+
+///
+/// \brief ColorTraceWriter::~ColorTraceWriter
+///
+ColorTraceWriter::~ColorTraceWriter()
+{
+	Close();
+}
+
+///
+/// \brief ColorTraceWriter::Open
+/// \param fileName
+/// \param freq
+/// \param fps
+/// \return
+///
+bool ColorTraceWriter::Open(const std::string& fileName, double freq, double fps)
+{
+	Close();
+
+	m_file.open(fileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+	ColorTraceHeader header;
+	header.m_recordSize = sizeof(ColorTraceRecord);
+	header.m_freq = freq;
+	header.m_fps = fps;
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	m_fullBlocks = std::make_unique<BoundedQueue<Block>>(QueueSize);
+	// Blocks in use: QueueSize in the queue, one in the writer thread and one in m_block, so Push never waits
+	m_freeBlocks = std::make_unique<BoundedQueue<Block>>(QueueSize + 2);
+	NewBlock();
+	m_thread = std::thread(&ColorTraceWriter::WriterThread, this);
+	return true;
+}
+
+///
+/// \brief ColorTraceWriter::IsOpened
+/// \return
+///
+bool ColorTraceWriter::IsOpened() const
+{
+	return m_thread.joinable();
+}
+
+///
+/// \brief ColorTraceWriter::Close
+///
+void ColorTraceWriter::Close()
+{
+	if (!IsOpened())
+	{
+		return;
+	}
+	if (!m_block.empty())
+	{
+		m_fullBlocks->Push(std::move(m_block));
+	}
+	m_fullBlocks->Close();
+	m_thread.join();
+
+	m_file.close();
+	m_block.clear();
+	m_fullBlocks.reset();
+	m_freeBlocks.reset();
+}
+
+///
+/// \brief ColorTraceWriter::Write
+/// \param record
+///
+void ColorTraceWriter::Write(const ColorTraceRecord& record)
+{
+	if (!IsOpened())
+	{
+		return;
+	}
+	m_block.push_back(record);
+	if (m_block.size() >= BlockSize)
+	{
+		m_fullBlocks->Push(std::move(m_block));
+		NewBlock();
+	}
+}
+
+///
+/// \brief ColorTraceWriter::NewBlock
+///
+void ColorTraceWriter::NewBlock()
+{
+	if (!m_freeBlocks->Pop(m_block, false))
+	{
+		m_block = Block();
+		m_block.reserve(BlockSize);
+	}
+}
+
+///
+/// \brief ColorTraceWriter::WriterThread
+///
+void ColorTraceWriter::WriterThread()
+{
+	Block block;
+	while (m_fullBlocks->Pop(block, true))
+	{
+		m_file.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(ColorTraceRecord));
+		block.clear();
+		m_freeBlocks->Push(std::move(block));
+	}
+	m_file.flush();
+}
+
+///
+/// \brief ColorTraceReader::Open
+/// \param fileName
+/// \return
+///
+bool ColorTraceReader::Open(const std::string& fileName)
+{
+	m_file.close();
+	m_file.clear();
+	m_file.open(fileName, std::ios_base::in | std::ios_base::binary);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+	m_header = ColorTraceHeader();
+	const ColorTraceHeader defHeader;
+	if (!m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header)) ||
+		memcmp(m_header.m_magic, defHeader.m_magic, sizeof(m_header.m_magic)) != 0 ||
+		m_header.m_version != defHeader.m_version ||
+		m_header.m_recordSize != sizeof(ColorTraceRecord))
+	{
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+///
+/// \brief ColorTraceReader::Header
+/// \return
+///
+const ColorTraceHeader& ColorTraceReader::Header() const
+{
+	return m_header;
+}
+
+///
+/// \brief ColorTraceReader::Read
+/// \param records
+/// \param maxCount
+/// \return
+///
+size_t ColorTraceReader::Read(ColorTraceRecord* records, size_t maxCount)
+{
+	if (!m_file.is_open() || !m_file.good())
+	{
+		return 0;
+	}
+	m_file.read(reinterpret_cast<char*>(records), maxCount * sizeof(ColorTraceRecord));
+	return static_cast<size_t>(m_file.gcount()) / sizeof(ColorTraceRecord);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <fstream>
+
+#include "BoundedQueue.h"
+
+#pragma pack(push, 1)
+///
+/// \brief The ColorTraceHeader struct
+/// Begin of the trace file, after it the ColorTraceRecord records are appended up to the end of file
+///
+struct ColorTraceHeader
+{
+	char m_magic[4] = { 'H', 'R', 'T', 'R' };
+	uint32_t m_version = 1;
+	uint32_t m_recordSize = 0;  // sizeof(ColorTraceRecord) of the writer
+	double m_freq = 0;          // Time stamps frequency: ticks per second
+	double m_fps = 0;
+};
+
+///
+/// \brief The ColorTraceRecord struct
+/// One frame of the trace: input of the signal plugin and the face position
+///
+struct ColorTraceRecord
+{
+	enum Flags
+	{
+		FaceFound = 1,   // The color value was measured and sent to the signal plugin
+		Detected = 2,    // Face detector worked on this frame
+		SkinMask = 4     // The color value was calculated on the skin pixels
+	};
+
+	int64_t m_captureTime = 0;
+	double m_rgb[3] = { 0, 0, 0 };
+	int32_t m_x = 0;
+	int32_t m_y = 0;
+	int32_t m_width = 0;
+	int32_t m_height = 0;
+	uint32_t m_flags = 0;
+};
+#pragma pack(pop)
+
+///
+/// \brief The ColorTraceWriter class
+/// Records are collected in the blocks, full blocks are written to the file in the separate thread
+///
+class ColorTraceWriter
+{
+public:
+	ColorTraceWriter() = default;
+	~ColorTraceWriter();
+
+	///
+	/// \brief Open
+	/// Create the new file and write the header
+	/// \param fileName
+	/// \param freq - time stamps frequency
+	/// \param fps
+	/// \return
+	///
+	bool Open(const std::string& fileName, double freq, double fps);
+	bool IsOpened() const;
+	///
+	/// \brief Close
+	/// Write all records and close the file
+	///
+	void Close();
+
+	///
+	/// \brief Write
+	/// Blocks only if the writer thread is behind on the queue of the full blocks
+	///
+	void Write(const ColorTraceRecord& record);
+
+private:
+	typedef std::vector<ColorTraceRecord> Block;
+	static const size_t BlockSize = 1024;
+	static const size_t QueueSize = 8;
+
+	std::ofstream m_file;
+	Block m_block;
+	// Full blocks go to the writer thread, written blocks return back and are reused
+	std::unique_ptr<BoundedQueue<Block>> m_fullBlocks;
+	std::unique_ptr<BoundedQueue<Block>> m_freeBlocks;
+	std::thread m_thread;
+
+	void WriterThread();
+	void NewBlock();
+};
+
+///
+/// \brief The ColorTraceReader class
+///
+class ColorTraceReader
+{
+public:
+	///
+	/// \brief Open
+	/// \return false if the file is not opened or it isn't a trace
+	///
+	bool Open(const std::string& fileName);
+	const ColorTraceHeader& Header() const;
+
+	///
+	/// \brief Read
+	/// Read the next records, the incomplete last record is ignored
+	/// \return Number of the readed records, 0 at the end of file
+	///
+	size_t Read(ColorTraceRecord* records, size_t maxCount);
+
+private:
+	std::ifstream m_file;
+	ColorTraceHeader m_header;
+};
@@ -0,0 +1,91 @@
+#include "FramePool.h"
+
+///
+/// \brief FramePool::Get
+/// \param size
+/// \param type
+/// \return
+///
+cv::Mat FramePool::Get(cv::Size size, int type)
+{
+	if (size.width <= 0 || size.height <= 0)
+	{
+		return cv::Mat();
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	++m_gets;
+	// Buffers of the different sizes are used alternately, so the free buffer is reallocated
+	// only if it wasn't requested for a long time, otherwise the pool would reallocate on every frame
+	const size_t staleGets = 2 * m_frames.size();
+	Frame* staleFrame = nullptr;
+	for (auto& frame : m_frames)
+	{
+		if (!IsFree(frame.m_frame))
+		{
+			continue;
+		}
+		if (frame.m_frame.size() == size && frame.m_frame.type() == type)
+		{
+			frame.m_lastUse = m_gets;
+			return frame.m_frame;
+		}
+		if (m_gets - frame.m_lastUse > staleGets && (!staleFrame || frame.m_lastUse < staleFrame->m_lastUse))
+		{
+			staleFrame = &frame;
+		}
+	}
+
+	++m_allocations;
+	if (!staleFrame)
+	{
+		m_frames.emplace_back();
+		staleFrame = &m_frames.back();
+	}
+	// Release before create: the old and the new buffers are not allocated at the same time
+	staleFrame->m_frame.release();
+	staleFrame->m_frame.create(size, type);
+	staleFrame->m_lastUse = m_gets;
+	return staleFrame->m_frame;
+}
+
+///
+/// \brief FramePool::Frames
+/// \return
+///
+size_t FramePool::Frames() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_frames.size();
+}
+
+///
+/// \brief FramePool::Allocations
+/// \return
+///
+size_t FramePool::Allocations() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_allocations;
+}
+
+///
+/// \brief FramePool::Clear
+///
+void FramePool::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_frames.clear();
+}
+
+///
+/// \brief FramePool::IsFree
+/// Only the pool refers to the buffer
+/// \param frame
+/// \return
+///
+bool FramePool::IsFree(const cv::Mat& frame)
+{
+	return frame.u && CV_XADD(&frame.u->refcount, 0) == 1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief The FramePool class
+/// Reusable frame buffers. The pool keeps own reference on every buffer, so the buffer is free
+/// when all Mat headers returned by Get (and their ROI) are released: nothing must be returned explicitly.
+/// Frames with the same size and type are reused without allocations.
+/// One pool can be shared by the frames of the different sizes: capture, processed frames and plots
+///
+class FramePool
+{
+public:
+	FramePool() = default;
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	///
+	/// \brief Get
+	/// The free buffer with the same size and type. If there is no such buffer then the stale free buffer
+	/// (not requested on the last Get calls, for example, after the frame size was changed) is reallocated
+	/// or the new one is added to the pool.
+	/// Content of the frame is undefined, empty Mat for the empty size
+	///
+	cv::Mat Get(cv::Size size, int type);
+
+	///
+	/// \brief Frames
+	/// Number of the buffers in the pool
+	///
+	size_t Frames() const;
+	///
+	/// \brief Allocations
+	/// Number of the buffer allocations from the pool creation: it doesn't grow on the steady state processing
+	///
+	size_t Allocations() const;
+
+	///
+	/// \brief Clear
+	/// Forget all buffers, the frames in use stay valid
+	///
+	void Clear();
+
+private:
+	struct Frame
+	{
+		cv::Mat m_frame;
+		size_t m_lastUse = 0;  // Number of the Get call that returned this buffer
+	};
+
+	mutable std::mutex m_mutex;
+	std::vector<Frame> m_frames;
+	size_t m_gets = 0;
+	size_t m_allocations = 0;
+
+	static bool IsFree(const cv::Mat& frame);
+};
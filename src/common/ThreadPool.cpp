@@ -0,0 +1,187 @@
+#include <iostream>
+
+#include "ThreadPool.h"
+
+namespace
+{
+	// Pool and queue index of the current worker thread
+	thread_local const ThreadPool* CurrPool = nullptr;
+	thread_local size_t CurrWorker = 0;
+}
+
+///
+/// \brief ThreadPool::ThreadPool
+/// \param threadsCount
+///
+ThreadPool::ThreadPool(size_t threadsCount)
+{
+	if (!threadsCount)
+	{
+		threadsCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+	for (size_t i = 0; i < threadsCount; ++i)
+	{
+		m_queues.emplace_back(new WorkerQueue());
+	}
+	for (size_t i = 0; i < threadsCount; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::Worker, this, i);
+	}
+}
+
+///
+/// \brief ThreadPool::~ThreadPool
+///
+ThreadPool::~ThreadPool()
+{
+	Stop();
+	for (auto& thread : m_threads)
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+}
+
+///
+/// \brief ThreadPool::Submit
+/// \param task
+/// \return
+///
+bool ThreadPool::Submit(Task task)
+{
+	size_t queueInd = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_stop)
+		{
+			return false;
+		}
+		++m_queued;
+		++m_pending;
+		queueInd = (CurrPool == this) ? CurrWorker : (m_nextQueue++ % m_queues.size());
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queueInd]->m_mutex);
+		m_queues[queueInd]->m_tasks.push_back(std::move(task));
+	}
+	m_condTask.notify_one();
+	return true;
+}
+
+///
+/// \brief ThreadPool::WaitAll
+///
+void ThreadPool::WaitAll()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condDone.wait(lock, [this]() { return m_pending == 0; });
+}
+
+///
+/// \brief ThreadPool::Stop
+///
+void ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condTask.notify_all();
+}
+
+///
+/// \brief ThreadPool::ThreadsCount
+/// \return
+///
+size_t ThreadPool::ThreadsCount() const
+{
+	return m_threads.size();
+}
+
+///
+/// \brief ThreadPool::FailedTasks
+/// \return
+///
+size_t ThreadPool::FailedTasks() const
+{
+	return m_failed;
+}
+
+///
+/// \brief ThreadPool::PopTask
+/// All queues are FIFO: a task that submits own continuation (one step of the stream) goes to the end
+/// of the worker queue, so the other tasks of this queue are not starved
+/// \param ind
+/// \param task
+/// \return
+///
+bool ThreadPool::PopTask(size_t ind, Task& task)
+{
+	bool res = false;
+	for (size_t i = 0; i < m_queues.size() && !res; ++i)
+	{
+		WorkerQueue& queue = *m_queues[(ind + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (!queue.m_tasks.empty())
+		{
+			task = std::move(queue.m_tasks.front());
+			queue.m_tasks.pop_front();
+			res = true;
+		}
+	}
+	if (res)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_queued;
+	}
+	return res;
+}
+
+///
+/// \brief ThreadPool::Worker
+/// \param ind
+///
+void ThreadPool::Worker(size_t ind)
+{
+	CurrPool = this;
+	CurrWorker = ind;
+
+	for (;;)
+	{
+		Task task;
+		if (PopTask(ind, task))
+		{
+			// The exception must not terminate the process or leave m_pending above 0 for WaitAll
+			try
+			{
+				task();
+			}
+			catch (const std::exception& ex)
+			{
+				++m_failed;
+				std::cerr << "ThreadPool: task failed: " << ex.what() << std::endl;
+			}
+			catch (...)
+			{
+				++m_failed;
+				std::cerr << "ThreadPool: task failed with unknown exception" << std::endl;
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_pending == 0)
+			{
+				m_condDone.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condTask.wait(lock, [this]() { return m_stop || m_queued > 0; });
+		if (m_stop && m_queued == 0)
+		{
+			break;
+		}
+	}
+}
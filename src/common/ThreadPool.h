@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+///
+/// \brief The ThreadPool class
+/// Work stealing thread pool: every worker has own tasks queue.
+/// Tasks submitted from a worker go to its queue, idle workers steal tasks from the other queues
+///
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	///
+	/// \param threadsCount - 0 for std::thread::hardware_concurrency()
+	///
+	explicit ThreadPool(size_t threadsCount = 0);
+	///
+	/// Executes all submitted tasks and stops the workers
+	///
+	~ThreadPool();
+
+	///
+	/// \brief Submit
+	/// \return false if the pool was stopped
+	///
+	bool Submit(Task task);
+
+	///
+	/// \brief WaitAll
+	/// Wait while all tasks (including the tasks submitted from the other tasks) are done
+	///
+	void WaitAll();
+
+	///
+	/// \brief Stop
+	/// New tasks are not accepted, already submitted tasks will be executed
+	///
+	void Stop();
+
+	size_t ThreadsCount() const;
+
+	///
+	/// \brief FailedTasks
+	/// Tasks finished by an exception: the worker catches it and continues, the caller reports the failed stream
+	///
+	size_t FailedTasks() const;
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex m_mutex;
+		std::deque<Task> m_tasks;
+	};
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condTask;
+	std::condition_variable m_condDone;
+	size_t m_queued = 0;   // Tasks in the queues
+	size_t m_pending = 0;  // Tasks in the queues and in work
+	size_t m_nextQueue = 0;
+	bool m_stop = false;
+	std::atomic<size_t> m_failed { 0 };
+
+	void Worker(size_t ind);
+	bool PopTask(size_t ind, Task& task);
+};
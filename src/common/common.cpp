@@ -46,6 +46,30 @@ bool OpenCapture(const std::string& fileName,
 	return false;
 }
 
+///
+/// \brief ReadFrame
+/// \param capture
+/// \param pool
+/// \param frame
+/// \return
+///
+bool ReadFrame(cv::VideoCapture& capture, FramePool& pool, cv::Mat& frame)
+{
+	cv::Size frameSize = frame.size();
+	int frameType = frame.empty() ? CV_8UC3 : frame.type();
+	if (frameSize.area() == 0)
+	{
+		frameSize.width = cvRound(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+		frameSize.height = cvRound(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+	}
+	// The previous frame is released first, so its buffer can be returned back
+	frame.release();
+	frame = pool.Get(frameSize, frameType);
+
+	// The backend writes in the buffer if the size and type are the same, otherwise the frame is reallocated
+	return capture.read(frame) && !frame.empty();
+}
+
 ///
 MeasureSettings::MeasureSettings()
 {
@@ -119,7 +143,23 @@ bool MeasureSettings::ParseOptions(const std::string& confFileName)
 		("config.gauss_proc_alpha", po::value<float>()->default_value(m_gauss_proc_alpha), "Coefficient for updating gaussian process weight")
 		("config.gauss_proc_weight_thresh", po::value<float>()->default_value(m_gauss_proc_weight_thresh), "If the weight of the Porocess is bigger then threshold then this Process is robust")
 		("config.signal_lib", po::value<std::string>()->default_value(m_signalLib), "Dynamic loaded library for signal processing and Heart rate estimation")
-		("config.snr_threshold", po::value<float>()->default_value(m_snrThresold), "SNR threshold for define correct measuring");
+		("config.snr_threshold", po::value<float>()->default_value(m_snrThresold), "SNR threshold for define correct measuring")
+		("config.pipeline", po::value<int>()->default_value(m_usePipeline ? 1 : 0), "Process detection, ROI and signal stages in the separate threads")
+		("config.pipeline_queue", po::value<int>()->default_value(m_pipelineQueueSize), "Queue size between the pipeline stages")
+		("config.detect_period_min", po::value<int>()->default_value(m_detectPeriodMin), "Minimal face detection period in frames, the face is tracked between the detections")
+		("config.detect_period_max", po::value<int>()->default_value(m_detectPeriodMax), "Maximal face detection period in frames for the static face")
+		("config.async_detection", po::value<int>()->default_value(m_asyncDetection ? 1 : 0), "Face detection in the separate thread, the result is corrected by the tracker")
+		("config.multi_face", po::value<int>()->default_value(m_multiFace ? 1 : 0), "Measure heart rate for all faces in the frame")
+		("config.max_subjects", po::value<int>()->default_value(m_maxSubjects), "Maximum number of the measured faces in the multi face mode")
+		("config.interpolation", po::value<int>()->default_value(m_interpolation), "Resampling of the signal on the uniform time grid: 0 - linear, 1 - cubic, 2 - Lanczos")
+		("config.band_spectrum", po::value<int>()->default_value(m_bandSpectrum ? 1 : 0), "Calculate only the spectrum bins in the heart rate band with the sliding DFT instead of the full FFT (signal_vpg only)")
+		("config.fft_size", po::value<int>()->default_value(m_fftSize), "Spectrum size: the signal is padded with zeros up to this size, 0 - the same as sample size")
+		("config.peak_interpolation", po::value<int>()->default_value(m_peakInterpolation), "Sub bin frequency of the spectrum peaks: 0 - no, 1 - parabolic, 2 - Jacobsen")
+		("config.measure_hop", po::value<int>()->default_value(m_measureHop), "Measure the frequency every N samples, between them the last result is returned")
+		("config.save_trace", po::value<int>()->default_value(m_saveTrace ? 1 : 0), "Record the colour values and face rects of the video to the binary trace for the replay")
+		("config.skin_refresh", po::value<int>()->default_value(m_skinRefresh), "Skin mask of the tracked face is classified by bands: 1/N of the rows on every frame, 1 - the full mask on every frame")
+		("config.roi_grid", po::value<int>()->default_value(m_roiGrid), "Face is divided to N x N cells, the cells colours are fused with the weights by their SNR")
+		("config.crop_only", po::value<int>()->default_value(m_cropOnly ? 1 : 0), "Without visual output the processed image contains only the face crop");
 
 	try
 	{
@@ -179,6 +219,23 @@ bool MeasureSettings::ParseOptions(const std::string& confFileName)
 #endif
 
 		m_snrThresold = variables["config.snr_threshold"].as<float>();
+
+		m_usePipeline = variables["config.pipeline"].as<int>() != 0;
+		m_pipelineQueueSize = variables["config.pipeline_queue"].as<int>();
+		m_detectPeriodMin = variables["config.detect_period_min"].as<int>();
+		m_detectPeriodMax = variables["config.detect_period_max"].as<int>();
+		m_asyncDetection = variables["config.async_detection"].as<int>() != 0;
+		m_multiFace = variables["config.multi_face"].as<int>() != 0;
+		m_maxSubjects = variables["config.max_subjects"].as<int>();
+		m_interpolation = static_cast<Interpolations>(std::max<int>(InterpLinear, std::min<int>(InterpLanczos, variables["config.interpolation"].as<int>())));
+		m_bandSpectrum = variables["config.band_spectrum"].as<int>() != 0;
+		m_fftSize = std::max(0, variables["config.fft_size"].as<int>());
+		m_peakInterpolation = static_cast<PeakInterpolations>(std::max<int>(PeakNone, std::min<int>(PeakJacobsen, variables["config.peak_interpolation"].as<int>())));
+		m_measureHop = std::max(1, variables["config.measure_hop"].as<int>());
+		m_saveTrace = variables["config.save_trace"].as<int>() != 0;
+		m_skinRefresh = std::max(1, variables["config.skin_refresh"].as<int>());
+		m_roiGrid = std::max(1, variables["config.roi_grid"].as<int>());
+		m_cropOnly = variables["config.crop_only"].as<int>() != 0;
 	}
 	catch (std::exception& ex)
 	{
@@ -3,6 +3,8 @@
 #include <opencv2/opencv.hpp>
 #include <fstream>
 
+#include "FramePool.h"
+
 ///
 inline char* PathSeparator()
 {
@@ -25,6 +27,16 @@ inline char* PathSeparator()
 ///
 bool OpenCapture(const std::string& fileName, cv::VideoCapture& capture, bool& useFPS, double& freq, double& fps, cv::VideoCaptureAPIs cameraBackend);
 
+///
+/// \brief ReadFrame
+/// The next frame is read into the buffer from the pool: with the size of the previous frame or with the capture frame size
+/// \param capture
+/// \param pool
+/// \param frame
+/// \return false in the end of the stream
+///
+bool ReadFrame(cv::VideoCapture& capture, FramePool& pool, cv::Mat& frame);
+
 ///
 /// \brief The MeasureSettings struct
 ///
@@ -53,6 +65,20 @@ struct MeasureSettings
 		VINO
 	};
 
+	enum Interpolations
+	{
+		InterpLinear,
+		InterpCubic,
+		InterpLanczos
+	};
+
+	enum PeakInterpolations
+	{
+		PeakNone,
+		PeakParabolic,
+		PeakJacobsen
+	};
+
 	cv::VideoCaptureAPIs m_cameraBackend = cv::CAP_ANY;
 	bool m_useOCL = false;
 	bool m_useMA = true;
@@ -85,6 +111,22 @@ struct MeasureSettings
 	bool m_saveResults = false;
 	std::string m_signalLib = "signal0";
 	float m_snrThresold = 2.5f;
+	bool m_usePipeline = false;
+	int m_pipelineQueueSize = 4;
+	int m_detectPeriodMin = 1;
+	int m_detectPeriodMax = 1;
+	bool m_asyncDetection = false;
+	bool m_multiFace = false;
+	int m_maxSubjects = 4;
+	Interpolations m_interpolation = InterpLinear;
+	bool m_bandSpectrum = false;
+	int m_fftSize = 0;
+	PeakInterpolations m_peakInterpolation = PeakNone;
+	int m_measureHop = 1;
+	bool m_saveTrace = false;
+	int m_skinRefresh = 1;
+	int m_roiGrid = 1;
+	bool m_cropOnly = false;
 
 	bool ParseOptions(const std::string& confFileName);
 
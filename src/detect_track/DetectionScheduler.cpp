@@ -0,0 +1,110 @@
+#include "DetectionScheduler.h"
+
+///
+/// \brief DetectionScheduler::DetectionScheduler
+///
+DetectionScheduler::DetectionScheduler()
+{
+}
+
+///
+/// \brief DetectionScheduler::Init
+/// \param minPeriod
+/// \param maxPeriod
+///
+void DetectionScheduler::Init(int minPeriod, int maxPeriod)
+{
+    m_minPeriod = std::max(1, minPeriod);
+    m_maxPeriod = std::max(m_minPeriod, maxPeriod);
+    Reset();
+}
+
+///
+/// \brief DetectionScheduler::Reset
+///
+void DetectionScheduler::Reset()
+{
+    m_period = m_minPeriod;
+    m_framesFromDetection = 0;
+    m_forceDetection = true;
+    m_motion = 0;
+}
+
+///
+/// \brief DetectionScheduler::NeedDetection
+/// \return
+///
+bool DetectionScheduler::NeedDetection() const
+{
+    return m_forceDetection || m_framesFromDetection >= m_period;
+}
+
+///
+/// \brief DetectionScheduler::Tracked
+/// \param prevRect
+/// \param currRect
+///
+void DetectionScheduler::Tracked(const cv::Rect& prevRect, const cv::Rect& currRect)
+{
+    if (prevRect.width <= 0 || currRect.width <= 0)
+    {
+        return;
+    }
+    double dx = (currRect.x + currRect.width / 2.) - (prevRect.x + prevRect.width / 2.);
+    double dy = (currRect.y + currRect.height / 2.) - (prevRect.y + prevRect.height / 2.);
+    double motion = std::sqrt(dx * dx + dy * dy) / prevRect.width + std::abs(currRect.width - prevRect.width) / static_cast<double>(prevRect.width);
+
+    m_motion = (1. - MotionAlpha) * m_motion + MotionAlpha * motion;
+}
+
+///
+/// \brief DetectionScheduler::Detected
+/// \param detectedRect
+/// \param trackedRect
+///
+void DetectionScheduler::Detected(const cv::Rect& detectedRect, const cv::Rect& trackedRect)
+{
+    m_framesFromDetection = 0;
+    m_forceDetection = false;
+
+    if (detectedRect.empty())
+    {
+        // Face was lost: detect it on every frame
+        m_period = m_minPeriod;
+        m_forceDetection = true;
+        return;
+    }
+
+    bool trackerDrift = false;
+    if (!trackedRect.empty())
+    {
+        float iou = (detectedRect & trackedRect).area() / static_cast<float>((detectedRect | trackedRect).area());
+        trackerDrift = iou < MinIoU;
+    }
+
+    if (trackerDrift || m_motion > HighMotion)
+    {
+        m_period = std::max(m_minPeriod, m_period / 2);
+    }
+    else if (m_motion < LowMotion)
+    {
+        m_period = std::min(m_maxPeriod, 2 * m_period);
+    }
+}
+
+///
+/// \brief DetectionScheduler::NextFrame
+///
+void DetectionScheduler::NextFrame()
+{
+    ++m_framesFromDetection;
+}
+
+///
+/// \brief DetectionScheduler::Period
+/// \return
+///
+int DetectionScheduler::Period() const
+{
+    return m_period;
+}
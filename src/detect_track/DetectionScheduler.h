@@ -0,0 +1,77 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+///
+/// \brief The DetectionScheduler class
+/// Decides on which frames the face detector must be run. Between detections the face is tracked.
+/// The detection period grows while the face is static and decreases on the fast motion
+/// or when the detector and tracker results diverge
+///
+class DetectionScheduler
+{
+public:
+    DetectionScheduler();
+
+    ///
+    /// \brief Init
+    /// \param minPeriod - minimal detection period in frames (1 - detect on every frame)
+    /// \param maxPeriod - maximal detection period in frames
+    ///
+    void Init(int minPeriod, int maxPeriod);
+
+    ///
+    /// \brief Reset
+    /// Detector will be run on the next frame
+    ///
+    void Reset();
+
+    ///
+    /// \brief NeedDetection
+    /// \return true if the detector must be run on the current frame
+    ///
+    bool NeedDetection() const;
+
+    ///
+    /// \brief Tracked
+    /// Face was tracked on the current frame
+    ///
+    void Tracked(const cv::Rect& prevRect, const cv::Rect& currRect);
+
+    ///
+    /// \brief Detected
+    /// Detector was run on the current frame
+    /// \param detectedRect - detection result (can be empty)
+    /// \param trackedRect - face position before the detection
+    ///
+    void Detected(const cv::Rect& detectedRect, const cv::Rect& trackedRect);
+
+    ///
+    /// \brief NextFrame
+    ///
+    void NextFrame();
+
+    ///
+    /// \brief Period
+    /// \return current detection period
+    ///
+    int Period() const;
+
+private:
+    int m_minPeriod = 1;
+    int m_maxPeriod = 1;
+    int m_period = 1;
+    int m_framesFromDetection = 0;
+    bool m_forceDetection = true;
+
+    ///
+    /// \brief m_motion
+    /// Smoothed face motion: center displacement per frame in the face widths
+    ///
+    double m_motion = 0;
+
+    static constexpr double LowMotion = 0.01;
+    static constexpr double HighMotion = 0.05;
+    static constexpr double MotionAlpha = 0.3;
+    static constexpr float MinIoU = 0.5f;
+};
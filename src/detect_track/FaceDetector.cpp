@@ -76,6 +76,34 @@ cv::Rect FaceDetectorHaar::DetectBiggestFace(cv::UMat image)
     return res;
 }
 
+///
+/// \brief FaceDetectorHaar::DetectAllFaces
+/// \param image
+/// \param faces
+///
+void FaceDetectorHaar::DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces)
+{
+    faces.clear();
+
+    if (m_cascade.empty())
+    {
+        assert(0);
+        return;
+    }
+
+    cv::UMat im;
+    if (image.channels() == 3)
+    {
+        cv::cvtColor(image, im, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        im = image;
+    }
+
+    m_cascade.detectMultiScale(im, faces, 1.1, 3, 0, cv::Size(image.cols / 16, image.rows / 16));
+}
+
 
 ///
 /// \brief FaceDetectorDNN::FaceDetectorDNN
@@ -140,6 +168,27 @@ cv::Rect FaceDetectorDNN::DetectBiggestFace(cv::UMat image)
 {
     cv::Rect res(0, 0, 0, 0);
 
+    DetectAllFaces(image, m_faces);
+    for (const auto& object : m_faces)
+    {
+        if (object.width > res.width)
+        {
+            res = object;
+        }
+    }
+
+    return res;
+}
+
+///
+/// \brief FaceDetectorDNN::DetectAllFaces
+/// \param image
+/// \param faces
+///
+void FaceDetectorDNN::DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces)
+{
+    faces.clear();
+
     const size_t inWidth = 300;
     const size_t inHeight = 300;
     const double inScaleFactor = 1.0;
@@ -176,13 +225,10 @@ cv::Rect FaceDetectorDNN::DetectBiggestFace(cv::UMat image)
             cv::Rect object(xLeftBottom, yLeftBottom, xRightTop - xLeftBottom, yRightTop - yLeftBottom);
 
             if (object.x >=0 && object.y >= 0 &&
-                    object.x + object.width < image.rows &&
-                    object.y + object.height < image.cols)
+                    object.x + object.width < image.cols &&
+                    object.y + object.height < image.rows)
             {
-                if (object.width > res.width)
-                {
-                    res = object;
-                }
+                faces.push_back(object);
             }
         }
 
@@ -190,8 +236,6 @@ cv::Rect FaceDetectorDNN::DetectBiggestFace(cv::UMat image)
         //std::cout << ", rect(" << detectionMat.at<float>(i, 3) << ", " << detectionMat.at<float>(i, 4) << ", ";
         //std::cout << detectionMat.at<float>(i, 5) << ", " << detectionMat.at<float>(i, 6) << ")" << std::endl;
     }
-
-    return res;
 }
 
 ///
@@ -277,3 +321,195 @@ FaceDetectorBase* CreateFaceDetector(
 
 	return faceDetector;
 }
+
+///
+/// \brief PerThreadFaceDetector::PerThreadFaceDetector
+/// \param factory
+/// \param detector
+///
+PerThreadFaceDetector::PerThreadFaceDetector(Factory factory, std::unique_ptr<FaceDetectorBase> detector)
+    :
+      FaceDetectorBase("", false),
+      m_factory(factory),
+      m_spareDetector(std::move(detector))
+{
+}
+
+///
+/// \brief PerThreadFaceDetector::~PerThreadFaceDetector
+///
+PerThreadFaceDetector::~PerThreadFaceDetector()
+{
+}
+
+///
+/// \brief PerThreadFaceDetector::DetectBiggestFace
+/// \param image
+/// \return
+///
+cv::Rect PerThreadFaceDetector::DetectBiggestFace(cv::UMat image)
+{
+    FaceDetectorBase* detector = ThreadDetector();
+    return detector ? detector->DetectBiggestFace(image) : cv::Rect();
+}
+
+///
+/// \brief PerThreadFaceDetector::DetectAllFaces
+/// \param image
+/// \param faces
+///
+void PerThreadFaceDetector::DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces)
+{
+    FaceDetectorBase* detector = ThreadDetector();
+    if (detector)
+    {
+        detector->DetectAllFaces(image, faces);
+    }
+    else
+    {
+        faces.clear();
+    }
+}
+
+///
+/// \brief PerThreadFaceDetector::ThreadDetector
+/// Detector of the current thread, it is created on the first call
+/// \return
+///
+FaceDetectorBase* PerThreadFaceDetector::ThreadDetector()
+{
+    const std::thread::id threadId = std::this_thread::get_id();
+    std::unique_ptr<FaceDetectorBase> detector;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_detectors.find(threadId);
+        if (it != m_detectors.end())
+        {
+            return it->second.get();
+        }
+        detector = std::move(m_spareDetector);
+    }
+    // The model is loaded without lock: the other threads continue their detections
+    if (!detector)
+    {
+        detector.reset(m_factory());
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FaceDetectorBase* res = detector.get();
+    m_detectors[threadId] = std::move(detector);
+    return res;
+}
+
+///
+/// \brief AsyncFaceDetector::AsyncFaceDetector
+/// \param detector
+///
+AsyncFaceDetector::AsyncFaceDetector(FaceDetectorBase* detector)
+    : m_detector(detector)
+{
+    m_thread = std::thread(&AsyncFaceDetector::Worker, this);
+}
+
+///
+/// \brief AsyncFaceDetector::~AsyncFaceDetector
+///
+AsyncFaceDetector::~AsyncFaceDetector()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+///
+/// \brief AsyncFaceDetector::Submit
+/// \param frame
+/// \param frameInd
+/// \return
+///
+bool AsyncFaceDetector::Submit(cv::Mat frame, int frameInd)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasTask)
+        {
+            return false;
+        }
+        // Worker doesn't touch the frame buffer while there is no task
+        frame.copyTo(m_frame);
+        m_frameInd = frameInd;
+        m_hasTask = true;
+    }
+    m_cond.notify_all();
+    return true;
+}
+
+///
+/// \brief AsyncFaceDetector::GetResult
+/// \param face
+/// \param frameInd
+/// \param wait
+/// \return
+///
+bool AsyncFaceDetector::GetResult(cv::Rect& face, int& frameInd, bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (wait)
+    {
+        m_cond.wait(lock, [this]() { return m_hasResult || !m_hasTask; });
+    }
+    if (!m_hasResult)
+    {
+        return false;
+    }
+    face = m_result;
+    frameInd = m_resultInd;
+    m_hasResult = false;
+    return true;
+}
+
+///
+/// \brief AsyncFaceDetector::IsBusy
+/// \return
+///
+bool AsyncFaceDetector::IsBusy() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hasTask;
+}
+
+///
+/// \brief AsyncFaceDetector::Worker
+///
+void AsyncFaceDetector::Worker()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || m_hasTask; });
+            if (m_stop)
+            {
+                break;
+            }
+        }
+
+        cv::UMat uframe = m_frame.getUMat(cv::ACCESS_READ);
+        cv::Rect face = m_detector->DetectBiggestFace(uframe);
+        uframe.release();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = face;
+            m_resultInd = m_frameInd;
+            m_hasResult = true;
+            m_hasTask = false;
+        }
+        m_cond.notify_all();
+    }
+}
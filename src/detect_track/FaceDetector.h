@@ -4,6 +4,12 @@
 #include <opencv2/dnn.hpp>
 #include <opencv2/dnn/shape_utils.hpp>
 #include <opencv2/face.hpp>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <map>
+#include <functional>
+#include <condition_variable>
 #include "../common/common.h"
 
 ///
@@ -23,6 +29,7 @@ public:
     }
 
     virtual cv::Rect DetectBiggestFace(cv::UMat image) = 0;
+    virtual void DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces) = 0;
 };
 
 ///
@@ -35,6 +42,7 @@ public:
     ~FaceDetectorHaar();
 
     cv::Rect DetectBiggestFace(cv::UMat image);
+    void DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces);
 
 private:
     double m_kw;
@@ -53,6 +61,7 @@ public:
     ~FaceDetectorDNN();
 
     cv::Rect DetectBiggestFace(cv::UMat image);
+    void DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces);
 
 private:
     cv::String m_modelConfiguration;
@@ -60,6 +69,8 @@ private:
     cv::dnn::Net m_net;
 
     float m_confidenceThreshold;
+
+    std::vector<cv::Rect> m_faces;
 };
 
 ///
@@ -78,5 +89,82 @@ private:
     cv::Ptr<cv::face::FacemarkKazemi> m_facemark;
 };
 
+///
+/// \brief The PerThreadFaceDetector class
+/// Face detector shared between several streams. cv::dnn::Net is not re-entrant, so every calling thread
+/// (the worker of the pool) has own detector created on the first call: T threads use T detectors
+/// for any number of streams and the detections of the different threads don't wait each other
+///
+class PerThreadFaceDetector : public FaceDetectorBase
+{
+public:
+    typedef std::function<FaceDetectorBase*()> Factory;
+
+    ///
+    /// \param factory - creates the new detector
+    /// \param detector - already created detector, it is used by the first calling thread
+    ///
+    PerThreadFaceDetector(Factory factory, std::unique_ptr<FaceDetectorBase> detector);
+    ~PerThreadFaceDetector();
+
+    cv::Rect DetectBiggestFace(cv::UMat image);
+    void DetectAllFaces(cv::UMat image, std::vector<cv::Rect>& faces);
+
+private:
+    Factory m_factory;
+    std::unique_ptr<FaceDetectorBase> m_spareDetector;
+    // The mutex guards only the map, the detectors work without lock
+    std::mutex m_mutex;
+    std::map<std::thread::id, std::unique_ptr<FaceDetectorBase>> m_detectors;
+
+    FaceDetectorBase* ThreadDetector();
+};
+
+///
+/// \brief The AsyncFaceDetector class
+/// Runs the face detector in the separate thread, only one frame can be in work
+///
+class AsyncFaceDetector
+{
+public:
+    AsyncFaceDetector(FaceDetectorBase* detector);
+    ~AsyncFaceDetector();
+
+    ///
+    /// \brief Submit
+    /// Copy the frame and start detection on it
+    /// \return false if the detector is busy with the previous frame
+    ///
+    bool Submit(cv::Mat frame, int frameInd);
+
+    ///
+    /// \brief GetResult
+    /// \param face - the biggest face (can be empty)
+    /// \param frameInd - index of the frame with this face
+    /// \param wait - wait for the frame in work
+    /// \return false if no new result
+    ///
+    bool GetResult(cv::Rect& face, int& frameInd, bool wait);
+
+    bool IsBusy() const;
+
+private:
+    FaceDetectorBase* m_detector = nullptr;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    cv::Mat m_frame;
+    int m_frameInd = 0;
+    bool m_hasTask = false;
+    cv::Rect m_result;
+    int m_resultInd = 0;
+    bool m_hasResult = false;
+    bool m_stop = false;
+
+    void Worker();
+};
+
 ///
 FaceDetectorBase* CreateFaceDetector(MeasureSettings::FaceDetectors detectorType, const std::string& appDirPath, bool useOCL);
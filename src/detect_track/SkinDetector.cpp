@@ -1,5 +1,6 @@
 #include "SkinDetector.h"
 #include <fstream>
+#include <algorithm>
 
 ///
 /// \brief SkinDetector::SkinDetector
@@ -28,12 +29,48 @@ SkinDetector::~SkinDetector()
 ///
 cv::Mat SkinDetector::Detect(cv::Mat image, bool drawResults, bool saveResult, int frameInd)
 {
-    if (m_skinMask.size() != image.size())
+    const bool sizeChanged = (m_skinMask.size() != image.size());
+    if (m_maskBuffer.rows < image.rows || m_maskBuffer.cols < image.cols)
     {
-        m_skinMask = cv::Mat(image.size(), CV_8UC1, cv::Scalar(255, 255, 255));
+        m_maskBuffer.create(std::max(m_maskBuffer.rows, image.rows), std::max(m_maskBuffer.cols, image.cols), CV_8UC1);
     }
+    m_skinMask = m_maskBuffer(cv::Rect(0, 0, image.cols, image.rows));
 
-    if (m_model)
+    if (m_lut)
+    {
+        const bool incremental = (m_refreshPeriod > 1) && !m_needRefresh && !sizeChanged;
+
+        // Stripes of the rows are processed in parallel, every stripe has own rows buffer
+        const int minStripeRows = 16;
+        const int stripes = incremental ? 1 : std::max(1, std::min(cv::getNumThreads(), image.rows / minStripeRows));
+        const size_t stripeBufSize = 4 * static_cast<size_t>(image.cols);
+        if (m_rowsBuffer.size() < stripes * stripeBufSize)
+        {
+            m_rowsBuffer.resize(stripes * stripeBufSize);
+        }
+
+        if (incremental)
+        {
+            // The rest of the mask was classified on the previous frames
+            const int bands = std::min(m_refreshPeriod, image.rows);
+            const int band = m_refreshBand % bands;
+            DetectRows(image, (band * image.rows) / bands, ((band + 1) * image.rows) / bands, &m_rowsBuffer[0]);
+            m_refreshBand = (band + 1) % bands;
+        }
+        else
+        {
+            cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range)
+            {
+                for (int s = range.start; s < range.end; ++s)
+                {
+                    DetectRows(image, (s * image.rows) / stripes, ((s + 1) * image.rows) / stripes, &m_rowsBuffer[s * stripeBufSize]);
+                }
+            });
+            m_refreshBand = 0;
+            m_needRefresh = false;
+        }
+    }
+    else if (m_model)
     {
         cv::Mat sample(1, 3, CV_32FC1);
         for (int y = 0; y < image.rows; ++y)
@@ -54,7 +91,16 @@ cv::Mat SkinDetector::Detect(cv::Mat image, bool drawResults, bool saveResult, i
                 ++maskPtr;
             }
         }
-		cv::dilate(m_skinMask, m_skinMask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3)));
+		// m_skinMask is a view: the pixels of m_maskBuffer outside it must not be used
+		cv::dilate(m_skinMask, m_skinMask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3)), cv::Point(-1, -1), 1, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+    }
+    else
+    {
+        m_skinMask.setTo(255);
+    }
+
+    if (m_model)
+    {
 		if (drawResults)
 		{
 			cv::imshow("skinMask", m_skinMask);
@@ -70,6 +116,89 @@ cv::Mat SkinDetector::Detect(cv::Mat image, bool drawResults, bool saveResult, i
     return m_skinMask;
 }
 
+///
+/// \brief SkinDetector::SetRefreshPeriod
+/// \param frames
+///
+void SkinDetector::SetRefreshPeriod(int frames)
+{
+    m_refreshPeriod = std::max(1, frames);
+    m_needRefresh = true;
+}
+
+///
+/// \brief SkinDetector::Refresh
+///
+void SkinDetector::Refresh()
+{
+    m_needRefresh = true;
+}
+
+///
+/// \brief SkinDetector::DetectRows
+/// \param image
+/// \param fromRow
+/// \param toRow
+/// \param buf
+///
+void SkinDetector::DetectRows(const cv::Mat& image, int fromRow, int toRow, uchar* buf)
+{
+    const SkinLUT& lut = *m_lut;
+    const int cols = image.cols;
+
+    // Classify the row and dilate it horizontally, the pixels outside the image are ignored as in cv::dilate
+    uchar* raw = buf;
+    auto HorDilatedRow = [&](int y, uchar* dst)
+    {
+        const uchar* imgPtr = image.ptr(y);
+        for (int x = 0; x < cols; ++x)
+        {
+            raw[x] = lut.m_mask[lut.m_offsets[0][imgPtr[0]] + lut.m_offsets[1][imgPtr[1]] + lut.m_offsets[2][imgPtr[2]]];
+            imgPtr += 3;
+        }
+        if (cols == 1)
+        {
+            dst[0] = raw[0];
+            return;
+        }
+        dst[0] = std::max(raw[0], raw[1]);
+        for (int x = 1; x < cols - 1; ++x)
+        {
+            dst[x] = std::max(raw[x - 1], std::max(raw[x], raw[x + 1]));
+        }
+        dst[cols - 1] = std::max(raw[cols - 2], raw[cols - 1]);
+    };
+
+    // 3 rows ring: row y is in the slot (y - fromRow + 1) % 3
+    uchar* rows[3] = { buf + cols, buf + 2 * cols, buf + 3 * cols };
+    auto Slot = [&](int y)
+    {
+        return rows[(y - fromRow + 1) % 3];
+    };
+    if (fromRow > 0)
+    {
+        HorDilatedRow(fromRow - 1, Slot(fromRow - 1));
+    }
+    HorDilatedRow(fromRow, Slot(fromRow));
+
+    for (int y = fromRow; y < toRow; ++y)
+    {
+        if (y + 1 < image.rows)
+        {
+            HorDilatedRow(y + 1, Slot(y + 1));
+        }
+        const uchar* r0 = Slot((y > 0) ? (y - 1) : y);
+        const uchar* r1 = Slot(y);
+        const uchar* r2 = Slot((y + 1 < image.rows) ? (y + 1) : y);
+
+        uchar* maskPtr = m_skinMask.ptr(y);
+        for (int x = 0; x < cols; ++x)
+        {
+            maskPtr[x] = std::max(r0[x], std::max(r1[x], r2[x]));
+        }
+    }
+}
+
 ///
 /// \brief SkinDetector::InitModel
 /// \param modelPath
@@ -83,6 +212,7 @@ bool SkinDetector::InitModel(std::string modelPath)
         if (dtree)
         {
             m_model = dtree;
+            BakeModel();
         }
     }
     catch(...)
@@ -93,6 +223,21 @@ bool SkinDetector::InitModel(std::string modelPath)
     return !m_model.empty();
 }
 
+///
+/// \brief SkinDetector::InitModel
+/// Use the model of the other detector, the skin mask is not shared
+/// \param skinDetector
+/// \return
+///
+bool SkinDetector::InitModel(const SkinDetector& skinDetector)
+{
+    m_model = skinDetector.m_model;
+    m_lut = skinDetector.m_lut;
+    m_useRGB = skinDetector.m_useRGB;
+
+    return !m_model.empty();
+}
+
 ///
 /// \brief SkinDetector::SaveModel
 /// \param modelPath
@@ -149,6 +294,79 @@ bool SkinDetector::LearnModel(std::string dataPath)
     dtree->setTruncatePrunedTree(false);
     dtree->train(trainData);
     m_model = dtree;
+    BakeModel();
+
+    return true;
+}
+
+///
+/// \brief SkinDetector::BakeModel
+/// \return
+///
+bool SkinDetector::BakeModel()
+{
+    m_lut.reset();
+
+    cv::Ptr<cv::ml::DTrees> dtree = m_model.dynamicCast<cv::ml::DTrees>();
+    if (!dtree)
+    {
+        return false;
+    }
+
+    // The first values of the channel intervals: split "val <= c" divides the channel between floor(c) and floor(c) + 1
+    std::vector<int> bounds[3];
+    for (auto& chanBounds : bounds)
+    {
+        chanBounds.push_back(0);
+    }
+    for (const auto& split : dtree->getSplits())
+    {
+        if (split.varIdx < 0 || split.varIdx > 2)
+        {
+            return false;
+        }
+        int bound = cvFloor(split.c) + 1;
+        if (bound > 0 && bound < 256)
+        {
+            bounds[split.varIdx].push_back(bound);
+        }
+    }
+    for (auto& chanBounds : bounds)
+    {
+        std::sort(chanBounds.begin(), chanBounds.end());
+        chanBounds.erase(std::unique(chanBounds.begin(), chanBounds.end()), chanBounds.end());
+    }
+
+    std::shared_ptr<SkinLUT> lut = std::make_shared<SkinLUT>();
+    const int strides[3] = { static_cast<int>(bounds[1].size() * bounds[2].size()), static_cast<int>(bounds[2].size()), 1 };
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int v = 0; v < 256; ++v)
+        {
+            int cell = static_cast<int>(std::upper_bound(bounds[c].begin(), bounds[c].end(), v) - bounds[c].begin()) - 1;
+            lut->m_offsets[c][v] = cell * strides[c];
+        }
+    }
+
+    // One prediction for every cell
+    lut->m_mask.resize(bounds[0].size() * bounds[1].size() * bounds[2].size());
+    cv::Mat sample(1, 3, CV_32FC1);
+    size_t ind = 0;
+    for (int b0 : bounds[0])
+    {
+        sample.at<float>(0, 0) = static_cast<float>(b0);
+        for (int b1 : bounds[1])
+        {
+            sample.at<float>(0, 1) = static_cast<float>(b1);
+            for (int b2 : bounds[2])
+            {
+                sample.at<float>(0, 2) = static_cast<float>(b2);
+                int response = (int)m_model->predict(sample);
+                lut->m_mask[ind++] = (response == 0) ? 255 : 0;
+            }
+        }
+    }
+    m_lut = lut;
 
     return true;
 }
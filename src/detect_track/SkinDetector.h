@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include "opencv2/opencv.hpp"
 
 ///
@@ -12,13 +13,66 @@ public:
     ~SkinDetector();
 
     bool InitModel(std::string modelPath = "../beatmagnifier/data/");
+    bool InitModel(const SkinDetector& skinDetector);
     bool SaveModel(std::string modelPath = "../beatmagnifier/data/");
     bool LearnModel(std::string dataPath = "../beatmagnifier/data/");
 
     cv::Mat Detect(cv::Mat image, bool drawResults, bool saveResult, int frameInd);
 
+    ///
+    /// \brief SetRefreshPeriod
+    /// Incremental mode for the tracked face: the face rect follows the face, so the previous mask is kept
+    /// and only 1/frames of the rows is classified on every frame. 1 - the full mask on every frame
+    ///
+    void SetRefreshPeriod(int frames);
+    ///
+    /// \brief Refresh
+    /// The face rect was changed not by the tracker (new detection): the next Detect classifies the full image
+    ///
+    void Refresh();
+
 private:
     cv::Mat m_skinMask;
+    ///
+    /// \brief m_maskBuffer
+    /// Has the size of the largest image, m_skinMask is the view on it
+    ///
+    cv::Mat m_maskBuffer;
+    ///
+    /// \brief m_rowsBuffer
+    /// Classified and horizontally dilated rows of every stripe
+    ///
+    std::vector<uchar> m_rowsBuffer;
+
+    int m_refreshPeriod = 1;
+    int m_refreshBand = 0;      // The band of rows that will be classified on the next frame
+    bool m_needRefresh = true;
+
+    ///
+    /// \brief The SkinLUT struct
+    /// The decision tree compiled to the table: every channel is quantized by the split thresholds of the tree,
+    /// so all colours of the one cell have the same class and the mask is the same as after predict
+    ///
+    struct SkinLUT
+    {
+        int m_offsets[3][256];     // Channel value -> cell offset in m_mask
+        std::vector<uchar> m_mask; // Mask value of the cell: 255 - skin, 0 - non skin
+    };
+    std::shared_ptr<const SkinLUT> m_lut;
+
+    ///
+    /// \brief BakeModel
+    /// Create m_lut from the m_model
+    /// \return false if the model isn't a decision tree
+    ///
+    bool BakeModel();
+
+    ///
+    /// \brief DetectRows
+    /// Classification with m_lut and dilation 3x3 of the mask rows [fromRow, toRow) in one pass
+    /// \param buf - 4 * image.cols bytes for the rows
+    ///
+    void DetectRows(const cv::Mat& image, int fromRow, int toRow, uchar* buf);
 
     std::string m_dataFileName;
     std::string m_modelFileName;
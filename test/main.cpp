@@ -156,6 +156,12 @@ int main(int argc, char* argv[])
 
     MainProcess mainProc(appDirPath);
     mainProc.Init(settings, videoFileName);
+	if (settings.m_usePipeline)
+	{
+		mainProc.StartPipeline(static_cast<size_t>(settings.m_pipelineQueueSize));
+	}
+	// Capture frames and the output images are taken from the same pool as the processed frames
+	FramePool& framePool = mainProc.GetFramePool();
 
     double tick_freq = cv::getTickFrequency();
 
@@ -163,27 +169,19 @@ int main(int argc, char* argv[])
 	
 	bool drawColors = true;
 
-    int frameInd = 0;
-    cv::Mat rgbframe;
-    for (capture >> rgbframe; !rgbframe.empty(); capture >> rgbframe)
+	// Show the processed frame and return the pressed key
+	auto ShowResult = [&](FrameResult& frameRes, bool faceFound, double t) -> int
 	{
-        int64 t1 = cv::getTickCount();
-        int64 captureTime = settings.m_useFPS ? static_cast<int64>((frameInd * 1000.) / settings.m_fps) : t1;
+		// In the crop_only mode the processed frame is the face crop only, the results are drawn on the input frame
+		cv::Mat& frame = (frameRes.m_imgProc.size() == frameRes.m_rgbFrame.size()) ? frameRes.m_imgProc : frameRes.m_rgbFrame;
 
-        cv::Mat frame;
-		cv::Scalar colorVal;
-        if (mainProc.Process(rgbframe, frame, captureTime, colorVal, true, true, false, true))
-        {
+		if (faceFound)
+		{
 			mainProc.DrawSignal(signalPlot, true, true);
 			mainProc.DrawFrequency(freqPlot);
-        }
-        else
-        {
-        }
-
-        int64 t2 = cv::getTickCount();
+		}
 
-        std::cout << frameInd << ": capture time = " << captureTime << std::endl;
+        std::cout << frameRes.m_frameInd << ": capture time = " << frameRes.m_captureTime << std::endl;
 
         // Draw color processing result
         frame(cv::Rect(frame.cols - freqPlot.cols, 0, freqPlot.cols, freqPlot.rows)) *= 0.5;
@@ -191,9 +189,9 @@ int main(int argc, char* argv[])
 		frame(cv::Rect(0, 0, signalPlot.cols, signalPlot.rows)) *= 0.5;
 		frame(cv::Rect(0, 0, signalPlot.cols, signalPlot.rows)) += 0.5 * signalPlot;
 		if (drawColors)
-			DrawColors(colorVal);
+			DrawColors(frameRes.m_colorVal);
 
-		int measure = mainProc.RemainingMeasurements();
+		int measure = frameRes.m_remainingMeasurements;
 		if (measure > 0)
 		{
 			std::string str = "Waiting for " + std::to_string(measure) + " frames";
@@ -202,24 +200,36 @@ int main(int argc, char* argv[])
 		else
 		{
 			char str[1024];
-			FrequencyResults freqResults;
-			mainProc.GetFrequency(&freqResults);
+			const FrequencyResults& freqResults = frameRes.m_freqResults;
 			sprintf(str, "[%2.2f, %2.2f] = %2.2f - %2.2f, snr = %2.2f", freqResults.minFreq, freqResults.maxFreq, freqResults.freq, freqResults.smootFreq, freqResults.snr);
 			cv::putText(frame, str, cv::Point(frame.cols - freqPlot.cols, freqPlot.rows / 3 - 5), cv::FONT_HERSHEY_COMPLEX, 0.7, cv::Scalar::all(255));
 		}
 
         // Draw detection data
-        cv::rectangle(frame, mainProc.GetFaceRect(), cv::Scalar(0, 255, 0), 1);
-        const std::vector<cv::Point2f>& currLandmarks = mainProc.GetCurrLandmarks();
-        for (auto pt : currLandmarks)
+        cv::rectangle(frame, frameRes.m_faceRect, cv::Scalar(0, 255, 0), 1);
+        for (auto pt : frameRes.m_landmarks)
         {
             cv::circle(frame, cv::Point(cvRound(pt.x), cvRound(pt.y)), 2, cv::Scalar(0, 150, 0), 1, cv::LINE_8);
         }
+		if (settings.m_multiFace)
+		{
+			for (const auto& subject : mainProc.GetSubjects())
+			{
+				if (!subject.m_found)
+				{
+					continue;
+				}
+				cv::rectangle(frame, subject.m_faceRect, cv::Scalar(0, 255, 0), 1);
+				std::string str = std::to_string(subject.m_id) + ": ";
+				str += (subject.m_remainingMeasurements > 0) ? "..." : std::to_string(cvRound(subject.m_freqResults.smootFreq));
+				cv::putText(frame, str, subject.m_faceRect.tl(), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0));
+			}
+		}
 
         if (settings.m_useMA)
         {
-            cv::Mat outImg(frame.rows, frame.cols * 2, CV_32FC3);
-            cv::hconcat(rgbframe, frame, outImg);
+            cv::Mat outImg = framePool.Get(cv::Size(frame.cols * 2, frame.rows), frame.type());
+            cv::hconcat(frameRes.m_rgbFrame, frame, outImg);
             cv::imshow(outWndName, outImg);
 
             if (videoWiter.isOpened())
@@ -237,9 +247,8 @@ int main(int argc, char* argv[])
             }
         }
 
-        double t = (t2 - t1) / tick_freq;
         int waitTime = manual ? 0 : (std::max<int>(1, static_cast<int>(1000 / settings.m_fps - t * 1000) - 1));
-		std::cout << frameInd << " (" << maxFrames << "): t = " << t << ", waitTime = " << waitTime << std::endl;
+		std::cout << frameRes.m_frameInd << " (" << maxFrames << "): t = " << t << ", waitTime = " << waitTime << std::endl;
         int k = cv::waitKey(waitTime);
 
         switch (k)
@@ -253,6 +262,57 @@ int main(int argc, char* argv[])
         case 27:
             break;
         }
+		return k;
+	};
+
+    int frameInd = 0;
+	// Frame pool statistics after the warm-up (the pipeline and the frame pool are filled)
+	const int warmUpFrames = 100;
+	size_t warmUpAllocations = 0;
+    cv::Mat rgbframe;
+    while (ReadFrame(capture, framePool, rgbframe))
+	{
+		if (frameInd == warmUpFrames)
+		{
+			warmUpAllocations = framePool.Allocations();
+		}
+        int64 t1 = cv::getTickCount();
+        int64 captureTime = settings.m_useFPS ? static_cast<int64>((frameInd * 1000.) / settings.m_fps) : t1;
+
+		int k = 0;
+		if (mainProc.IsPipelineStarted())
+		{
+			// The frame buffer now belongs to the pipeline, it returns to the pool with the result
+			mainProc.PushFrame(std::move(rgbframe), captureTime, true, false);
+
+			// All ready results are shown, otherwise the display falls behind the capture on every missed pop.
+			// The time from the iteration start includes the previous results, so only the first one waits the frame period
+			FrameResult frameRes;
+			while (k != 27 && mainProc.PopResult(frameRes, false))
+			{
+				int64 t2 = cv::getTickCount();
+				k = ShowResult(frameRes, frameRes.m_faceRect.area() > 0, (t2 - t1) / tick_freq);
+			}
+		}
+		else
+		{
+			FrameResult frameRes;
+			frameRes.m_rgbFrame = rgbframe;
+			frameRes.m_captureTime = captureTime;
+			frameRes.m_frameInd = frameInd;
+			bool faceFound = mainProc.Process(rgbframe, frameRes.m_imgProc, captureTime, frameRes.m_colorVal, true, true, false, true);
+
+			int64 t2 = cv::getTickCount();
+
+			frameRes.m_faceRect = mainProc.GetFaceRect();
+			frameRes.m_landmarks = mainProc.GetCurrLandmarks();
+			frameRes.m_remainingMeasurements = mainProc.RemainingMeasurements();
+			if (frameRes.m_remainingMeasurements == 0)
+			{
+				mainProc.GetFrequency(&frameRes.m_freqResults);
+			}
+			k = ShowResult(frameRes, faceFound, (t2 - t1) / tick_freq);
+		}
 
         if (k == 27)
         {
@@ -262,6 +322,23 @@ int main(int argc, char* argv[])
         ++frameInd;
 	}
 
+	if (mainProc.IsPipelineStarted())
+	{
+		mainProc.StopPipeline(true);
+		FrameResult frameRes;
+		while (mainProc.PopResult(frameRes, true))
+		{
+			if (ShowResult(frameRes, frameRes.m_faceRect.area() > 0, 0) == 27)
+			{
+				break;
+			}
+		}
+	}
+
+	const size_t steadyAllocations = (frameInd > warmUpFrames) ? (framePool.Allocations() - warmUpAllocations) : 0;
+	std::cout << "Frame pool: " << framePool.Frames() << " buffers, " << framePool.Allocations() << " allocations, "
+			  << steadyAllocations << " after the warm-up" << std::endl;
+
     cv::waitKey(1000);
 
     return 0;
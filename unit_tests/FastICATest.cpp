@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "beat_calc/signal0/FastICA.h"
+
+#ifndef EIGEN_RUNTIME_NO_MALLOC
+#error "FastICATest checks the Eigen allocations: build it with EIGEN_RUNTIME_NO_MALLOC"
+#endif
+
+///
+/// \brief MakeSources
+/// Pulse, slow motion and noise mixed to the 3 colour channels
+///
+void MakeSources(int samples, double fps, cv::Mat& pulse, cv::Mat& mixed)
+{
+	cv::RNG rng(12345);
+	const double mixing[3][3] = { { 0.3, 1.0, 0.4 }, { 1.0, 0.8, 0.2 }, { 0.5, 0.9, 0.6 } };
+
+	pulse.create(1, samples, CV_64FC1);
+	mixed.create(3, samples, CV_64FC1);
+	for (int i = 0; i < samples; ++i)
+	{
+		const double t = i / fps;
+		const double sources[3] = { sin(2. * CV_PI * 1.2 * t), sin(2. * CV_PI * 0.23 * t) > 0 ? 1. : -1., rng.uniform(-1., 1.) };
+		pulse.at<double>(i) = sources[0];
+		for (int c = 0; c < 3; ++c)
+		{
+			mixed.at<double>(c, i) = 100. + mixing[c][0] * sources[0] + mixing[c][1] * sources[1] + mixing[c][2] * sources[2];
+		}
+	}
+}
+
+///
+/// \brief main
+/// FastICA::apply on the sliding window: no Eigen allocations after the first window
+/// (eigen_assert aborts the test) and the pulse is one of the independent components
+///
+int main()
+{
+	const int windowSize = 256;
+	const int windows = 100;
+	const double fps = 25.;
+
+	cv::Mat pulse;
+	cv::Mat mixed;
+	MakeSources(windowSize + windows, fps, pulse, mixed);
+
+	FastICA ica;
+	cv::Mat window(3, windowSize, CV_64FC1);
+	cv::Mat dst;
+	cv::Mat mixing;
+	bool res = true;
+	int maxIterations = 0;
+	for (int i = 0; i < windows; ++i)
+	{
+		mixed.colRange(i, i + windowSize).copyTo(window);
+		ica.apply(window, dst, mixing);
+		if (i > 0)
+		{
+			maxIterations = std::max(maxIterations, ica.Iterations());
+		}
+
+		double bestCorr = 0;
+		cv::Mat pulseWindow = pulse.colRange(i, i + windowSize);
+		for (int c = 0; c < 3; ++c)
+		{
+			cv::Mat comp = dst.row(c);
+			cv::Scalar compMean;
+			cv::Scalar compStd;
+			cv::meanStdDev(comp, compMean, compStd);
+			cv::Scalar pulseMean;
+			cv::Scalar pulseStd;
+			cv::meanStdDev(pulseWindow, pulseMean, pulseStd);
+			const double cov = cv::Mat(comp - compMean[0]).dot(cv::Mat(pulseWindow - pulseMean[0])) / windowSize;
+			bestCorr = std::max(bestCorr, std::abs(cov / std::max(compStd[0] * pulseStd[0], 1e-12)));
+		}
+		if (bestCorr < 0.9)
+		{
+			std::cerr << "Window " << i << ": pulse wasn't separated, correlation = " << bestCorr << std::endl;
+			res = false;
+		}
+	}
+	std::cout << "FastICA: " << windows << " windows without Eigen allocations, max " << maxIterations << " iterations from the previous window" << std::endl;
+	return res ? 0 : 1;
+}
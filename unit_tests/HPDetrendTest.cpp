@@ -0,0 +1,109 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "beat_calc/signal0/detrend.h"
+
+///
+/// \brief DenseDetrend
+/// Reference solution: r = z - x, where (I + lambda^2 * D2' * D2) * x = z with the dense matrices
+///
+cv::Mat DenseDetrend(const cv::Mat& z, int lambda)
+{
+	const int t = static_cast<int>(z.total());
+	cv::Mat zCol = z.reshape(1, t);
+	if (t < 3)
+	{
+		return zCol.reshape(1, 1).clone();
+	}
+	cv::Mat d2 = cv::Mat::zeros(t - 2, t, CV_64FC1);
+	for (int k = 0; k < t - 2; ++k)
+	{
+		d2.at<double>(k, k) = 1.;
+		d2.at<double>(k, k + 1) = -2.;
+		d2.at<double>(k, k + 2) = 1.;
+	}
+	cv::Mat a = cv::Mat::eye(t, t, CV_64FC1) + static_cast<double>(lambda) * lambda * d2.t() * d2;
+	cv::Mat x;
+	cv::solve(a, zCol, x, cv::DECOMP_CHOLESKY);
+	cv::Mat r = zCol - x;
+	return r.reshape(1, 1);
+}
+
+///
+/// \brief MakeSignal
+/// Slow trend, pulse and noise as the colour signal of the face
+///
+cv::Mat MakeSignal(int t, cv::RNG& rng)
+{
+	cv::Mat z(1, t, CV_64FC1);
+	for (int i = 0; i < t; ++i)
+	{
+		const double time = i / 25.;
+		z.at<double>(i) = 150. + 3. * time + 2. * sin(2. * CV_PI * 0.1 * time) + sin(2. * CV_PI * 1.2 * time) + rng.gaussian(0.3);
+	}
+	return z;
+}
+
+///
+/// \brief Compare
+/// \return false if HPDetrend differs from the dense solution
+///
+bool Compare(const std::string& name, const cv::Mat& res, const cv::Mat& ref, const cv::Mat& z)
+{
+	const double eps = 1e-9 * std::max(1., cv::norm(z, cv::NORM_INF));
+	const double diff = (res.size() == ref.size()) ? cv::norm(res, ref, cv::NORM_INF) : -1;
+	if (diff < 0 || diff > eps)
+	{
+		std::cerr << name << ": size = " << z.total() << ", max difference = " << diff << std::endl;
+		return false;
+	}
+	return true;
+}
+
+///
+/// \brief main
+/// HPDetrend (banded LDL') must give the same result as the dense solve of the Hodrick-Prescott system
+///
+int main()
+{
+	const int sizes[] = { 1, 2, 3, 4, 5, 16, 128, 257 };
+	const int lambdas[] = { 1, 10, 13, 50 };
+
+	cv::RNG rng(12345);
+	HPDetrend detrend;
+	bool res = true;
+	int tests = 0;
+	for (int t : sizes)
+	{
+		for (int lambda : lambdas)
+		{
+			cv::Mat z = MakeSignal(t, rng);
+			cv::Mat ref = DenseDetrend(z, lambda);
+
+			// The cached factorization is used on the second call
+			for (int i = 0; i < 2; ++i)
+			{
+				cv::Mat r;
+				detrend.Apply(z, r, lambda);
+				res &= Compare("Row", r, ref, z);
+			}
+
+			// Column vector input
+			cv::Mat r;
+			detrend.Apply(z.reshape(1, t), r, lambda);
+			res &= Compare("Column", r, ref, z);
+
+			// In place
+			cv::Mat inPlace = z.clone();
+			detrend.Apply(inPlace.ptr<double>(), inPlace.ptr<double>(), t, lambda);
+			res &= Compare("In place", inPlace, ref, z);
+
+			++tests;
+		}
+	}
+	std::cout << "HPDetrend: " << tests << " signals compared with the dense solution" << std::endl;
+	return res ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cmath>
+
+#include "beat_calc/MainProcess.h"
+
+///
+/// \brief The CountingAllocator class
+/// Default allocator of cv::Mat and cv::UMat (without OpenCL): the frame buffers are allocated by cv::fastMalloc,
+/// not by operator new, so they are counted here. Only the buffers not smaller than minBytes are counted
+///
+class CountingAllocator : public cv::MatAllocator
+{
+public:
+	CountingAllocator()
+		: m_std(cv::Mat::getStdAllocator())
+	{
+	}
+
+	cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+	{
+		// The header for the existing data (getUMat, user buffer) doesn't allocate the buffer
+		if (!data)
+		{
+			size_t bytes = CV_ELEM_SIZE(type);
+			for (int i = 0; i < dims; ++i)
+			{
+				bytes *= static_cast<size_t>(sizes[i]);
+			}
+			if (bytes >= m_minBytes)
+			{
+				++m_allocations;
+			}
+		}
+		return m_std->allocate(dims, sizes, type, data, step, flags, usageFlags);
+	}
+
+	bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+	{
+		return m_std->allocate(data, accessFlags, usageFlags);
+	}
+
+	void deallocate(cv::UMatData* data) const override
+	{
+		m_std->deallocate(data);
+	}
+
+	void SetMinBytes(size_t minBytes)
+	{
+		m_minBytes = minBytes;
+	}
+	size_t Allocations() const
+	{
+		return m_allocations;
+	}
+
+private:
+	cv::MatAllocator* m_std = nullptr;
+	size_t m_minBytes = 0;
+	mutable std::atomic<size_t> m_allocations { 0 };
+};
+
+///
+/// \brief The FixedFaceDetector class
+/// The face is always in the same place: the test doesn't need the detector models
+///
+class FixedFaceDetector : public FaceDetectorBase
+{
+public:
+	FixedFaceDetector(const cv::Rect& face)
+		: FaceDetectorBase("", false), m_face(face)
+	{
+	}
+
+	cv::Rect DetectBiggestFace(cv::UMat /*image*/)
+	{
+		return m_face;
+	}
+	void DetectAllFaces(cv::UMat /*image*/, std::vector<cv::Rect>& faces)
+	{
+		faces.assign(1, m_face);
+	}
+
+private:
+	cv::Rect m_face;
+};
+
+///
+/// \brief MakeFrame
+/// Synthetic frame: gradient background and the face with the brightness changed by the pulse, without allocations
+///
+void MakeFrame(cv::Mat frame, const cv::Rect& face, int frameInd, double fps)
+{
+	const int pulse = cvRound(4. * sin(2. * CV_PI * 1.2 * frameInd / fps));
+	for (int y = 0; y < frame.rows; ++y)
+	{
+		uchar* ptr = frame.ptr(y);
+		const bool faceRow = (y >= face.y && y < face.y + face.height);
+		for (int x = 0; x < frame.cols; ++x, ptr += 3)
+		{
+			if (faceRow && x >= face.x && x < face.x + face.width)
+			{
+				ptr[0] = cv::saturate_cast<uchar>(120 + (x + y) % 16);
+				ptr[1] = cv::saturate_cast<uchar>(150 + pulse + (x - y) % 8);
+				ptr[2] = cv::saturate_cast<uchar>(200 + (x * y) % 8);
+			}
+			else
+			{
+				ptr[0] = static_cast<uchar>(x % 256);
+				ptr[1] = static_cast<uchar>(y % 256);
+				ptr[2] = static_cast<uchar>((x + y) % 256);
+			}
+		}
+	}
+}
+
+///
+/// \brief TestFramePath
+/// MainProcess::Process on the capture frames from its own frame pool, as HeartRateMeasure does it
+/// \return false if the frame buffers were allocated after the warm-up
+///
+bool TestFramePath(const std::string& name, MeasureSettings settings, CountingAllocator& allocator)
+{
+	const cv::Size frameSize(640, 480);
+	const cv::Rect face(260, 150, 120, 140);
+	const int warmUpFrames = 50;
+	const int testFrames = 200;
+
+	// Frame size buffers: the copies and conversions of the whole frame, the capture frames held by MainProcess
+	allocator.SetMinBytes(frameSize.area() * 3);
+
+	SharedResources resources;
+	resources.m_faceDetector = std::make_shared<FixedFaceDetector>(face);
+
+	MainProcess mainProc(".");
+	if (!mainProc.Init(settings, "", resources))
+	{
+		std::cerr << name << ": MainProcess wasn't initialized" << std::endl;
+		return false;
+	}
+	FramePool& pool = mainProc.GetFramePool();
+
+	size_t allocations = 0;
+	size_t poolAllocations = 0;
+	bool faceFound = true;
+	cv::Mat imgProc;
+	cv::Scalar colorVal;
+	for (int frameInd = 0; frameInd < warmUpFrames + testFrames; ++frameInd)
+	{
+		if (frameInd == warmUpFrames)
+		{
+			allocations = allocator.Allocations();
+			poolAllocations = pool.Allocations();
+		}
+
+		// The previous capture frame is released here and returns to the pool
+		cv::Mat frame = pool.Get(frameSize, CV_8UC3);
+		MakeFrame(frame, face, frameInd, settings.m_fps);
+		int64 captureTime = static_cast<int64>((frameInd * 1000.) / settings.m_fps);
+		faceFound &= mainProc.Process(frame, imgProc, captureTime, colorVal, false, false, false, false);
+	}
+
+	const size_t testAllocations = allocator.Allocations() - allocations;
+	const size_t testPoolAllocations = pool.Allocations() - poolAllocations;
+	std::cout << name << ": " << testAllocations << " frame buffers allocations, " << testPoolAllocations
+			  << " pool allocations on " << testFrames << " frames after the warm-up, " << pool.Frames() << " buffers in the pool" << std::endl;
+
+	bool res = true;
+	if (!faceFound)
+	{
+		std::cerr << name << ": face was lost" << std::endl;
+		res = false;
+	}
+	if (testAllocations || testPoolAllocations)
+	{
+		std::cerr << name << ": frame buffers were allocated on the steady state" << std::endl;
+		res = false;
+	}
+	return res;
+}
+
+///
+/// \brief main
+/// The steady state frame path of MainProcess must not allocate the frame buffers:
+/// SimpleMA on the whole frame, on the face crop and the crop only mode. Skin model and signal plugin are not used
+///
+int main()
+{
+	cv::ocl::setUseOpenCL(false);
+	cv::setNumThreads(0);
+
+	static CountingAllocator allocator;
+	cv::Mat::setDefaultAllocator(&allocator);
+
+	MeasureSettings settings;
+	settings.m_fps = 25;
+	settings.m_useFPS = true;
+	settings.m_useOCL = false;
+	settings.m_useSkinDetection = false;
+	settings.m_signalLib = "";
+	settings.m_useMA = true;
+	settings.m_maAlgorithm = MeasureSettings::Simple;
+	settings.m_roiGrid = 1;
+	settings.m_detectPeriodMin = 1;
+	settings.m_detectPeriodMax = 1;
+
+	bool res = true;
+
+	settings.m_maUseCrop = false;
+	res &= TestFramePath("MA on the frame", settings, allocator);
+
+	settings.m_maUseCrop = true;
+	res &= TestFramePath("MA on the crop", settings, allocator);
+
+	settings.m_cropOnly = true;
+	res &= TestFramePath("Crop only", settings, allocator);
+
+	cv::Mat::setDefaultAllocator(nullptr);
+	return res ? 0 : 1;
+}
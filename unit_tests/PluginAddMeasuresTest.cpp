@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "beat_calc/FaceSubject.h"
+
+///
+/// \brief SameResults
+/// Both plugin instances run the same code on the same samples: the results must be equal exactly
+///
+bool SameResults(const FrequencyResults& r1, const FrequencyResults& r2)
+{
+	return r1.smootFreq == r2.smootFreq &&
+			r1.freq == r2.freq &&
+			r1.minFreq == r2.minFreq &&
+			r1.maxFreq == r2.maxFreq &&
+			r1.snr == r2.snr &&
+			r1.averageCardiointerval == r2.averageCardiointerval &&
+			r1.currentCardiointerval == r2.currentCardiointerval;
+}
+
+///
+/// \brief TestPlugin
+/// One instance receives the blocks of samples by AddMeasures, another one - the same samples by AddMeasure.
+/// The block sizes are not multiple of the measure hop, so the blocks cross the hop boundaries
+/// \return false if the frequency or the remaining measurements are different
+///
+bool TestPlugin(const std::string& pluginName, const MeasureSettings& settings)
+{
+	SignalPlugin blockPlugin;
+	SignalPlugin samplePlugin;
+	if (!blockPlugin.LoadPlugin(pluginName) || !samplePlugin.LoadPlugin(pluginName))
+	{
+		std::cerr << pluginName << ": plugin wasn't loaded" << std::endl;
+		return false;
+	}
+	InputParams inputParams = MakeInputParams(settings);
+	if (!blockPlugin.Init(&inputParams) || !samplePlugin.Init(&inputParams))
+	{
+		std::cerr << pluginName << ": plugin wasn't initialized" << std::endl;
+		return false;
+	}
+
+	const int samplesCount = 4 * settings.m_sampleSize;
+	const double pulseFreq = 1.2;
+
+	std::vector<__int64> captureTimes(samplesCount);
+	std::vector<double> rgb(3 * samplesCount);
+	for (int i = 0; i < samplesCount; ++i)
+	{
+		captureTimes[i] = static_cast<__int64>((i * 1000.) / settings.m_fps);
+		const double t = captureTimes[i] / 1000.;
+		const double pulse = sin(2. * CV_PI * pulseFreq * t);
+		const double noise = sin(2. * CV_PI * 0.13 * t) + 0.3 * sin(2. * CV_PI * 7.3 * t);
+		rgb[3 * i + 0] = 120. + 0.3 * pulse + noise;
+		rgb[3 * i + 1] = 150. + pulse + noise;
+		rgb[3 * i + 2] = 200. + 0.5 * pulse + noise;
+	}
+
+	bool res = true;
+	int blocks = 0;
+	FrequencyResults blockResults;
+	for (int from = 0, blockSize = 1; from < samplesCount; from += blockSize, blockSize = 1 + (blockSize + 3) % 11)
+	{
+		const int count = std::min(blockSize, samplesCount - from);
+
+		blockPlugin.AddMeasures(count, &captureTimes[from], &rgb[3 * from]);
+		for (int i = from; i < from + count; ++i)
+		{
+			samplePlugin.AddMeasure(captureTimes[i], &rgb[3 * i]);
+		}
+
+		const int frameInd = from + count - 1;
+		blockPlugin.MeasureFrequency(settings.m_freq, frameInd, false);
+		samplePlugin.MeasureFrequency(settings.m_freq, frameInd, false);
+
+		FrequencyResults sampleResults;
+		blockPlugin.GetFrequency(&blockResults);
+		samplePlugin.GetFrequency(&sampleResults);
+		const int blockRemaining = blockPlugin.RemainingMeasurements();
+		const int sampleRemaining = samplePlugin.RemainingMeasurements();
+
+		if (!SameResults(blockResults, sampleResults) || blockRemaining != sampleRemaining)
+		{
+			std::cerr << pluginName << ": different results on frame " << frameInd << ": freq = " << blockResults.freq << " and " << sampleResults.freq
+					  << ", remaining = " << blockRemaining << " and " << sampleRemaining << std::endl;
+			res = false;
+		}
+		++blocks;
+	}
+	std::cout << pluginName << ": " << samplesCount << " samples in " << blocks << " blocks, last freq = " << blockResults.freq << std::endl;
+	return res;
+}
+
+///
+/// \brief main
+/// AddMeasures of each signal plugin must give the same results as the repeated AddMeasure
+/// argv - the plugin library paths
+///
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: PluginAddMeasuresTest <plugin library>..." << std::endl;
+		return 1;
+	}
+
+	MeasureSettings settings;
+	settings.m_fps = 25;
+	settings.m_sampleSize = 128;
+	settings.m_measureHop = 5;
+
+	bool res = true;
+	for (int i = 1; i < argc; ++i)
+	{
+		res &= TestPlugin(argv[i], settings);
+	}
+	return res ? 0 : 1;
+}
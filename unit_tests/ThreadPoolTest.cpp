@@ -0,0 +1,80 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+
+#include "common/ThreadPool.h"
+
+///
+/// \brief main
+/// Streams are simulated as in HeartRateServer: every step submits the next step of the same stream.
+/// With more streams than threads all streams must make progress
+///
+int main()
+{
+	const size_t threadsCount = 2;
+	const size_t streamsCount = 8;
+	const size_t totalSteps = 4000;
+
+	std::vector<std::atomic<size_t>> steps(streamsCount);
+	for (auto& s : steps)
+	{
+		s = 0;
+	}
+	std::atomic<size_t> done(0);
+
+	ThreadPool pool(threadsCount);
+	std::function<void(size_t)> streamStep = [&](size_t stream)
+	{
+		// Processing of the one frame
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		++steps[stream];
+		if (++done < totalSteps)
+		{
+			pool.Submit([&streamStep, stream]() { streamStep(stream); });
+		}
+	};
+	for (size_t i = 0; i < streamsCount; ++i)
+	{
+		pool.Submit([&streamStep, i]() { streamStep(i); });
+	}
+	pool.WaitAll();
+
+	// Fair scheduling gives totalSteps / streamsCount steps to every stream
+	const size_t minSteps = totalSteps / (4 * streamsCount);
+	int res = 0;
+	for (size_t i = 0; i < streamsCount; ++i)
+	{
+		std::cout << "Stream " << i << ": " << steps[i] << " steps" << std::endl;
+		if (steps[i] < minSteps)
+		{
+			std::cerr << "Stream " << i << " is starved: " << steps[i] << " < " << minSteps << std::endl;
+			res = 1;
+		}
+	}
+
+	// A failed task doesn't stop the worker and WaitAll
+	std::atomic<size_t> completed(0);
+	for (size_t i = 0; i < 4 * threadsCount; ++i)
+	{
+		pool.Submit([&completed, i]()
+		{
+			if (i % 2)
+			{
+				throw std::runtime_error("test exception");
+			}
+			++completed;
+		});
+	}
+	pool.WaitAll();
+	std::cout << pool.FailedTasks() << " tasks failed, " << completed << " completed" << std::endl;
+	if (pool.FailedTasks() != 2 * threadsCount || completed != 2 * threadsCount)
+	{
+		std::cerr << "Failed tasks were not counted" << std::endl;
+		res = 1;
+	}
+	return res;
+}